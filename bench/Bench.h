@@ -0,0 +1,240 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metrics/Histogram.h"
+#include "os/Placement.h"
+#include "os/Topology.h"
+#include "os/perf/Perf.h"
+
+namespace conq::bench {
+    struct Options final {
+        std::uint64_t ops = 200'000;
+        std::string filter{};
+        std::string out{};
+        std::uint64_t bytes = 16 << 20;
+        bool pin = true;
+        int first_cpu = 0;
+        int peer_cpu = 1;
+    };
+
+    /**
+     * --ops=N        operations per benchmark (split across producers)
+     * --filter=TEXT  run only benchmarks whose name contains TEXT
+     * --out=FILE     write JSON to FILE instead of stdout
+     * --bytes=N      bytes streamed per bandwidth measurement
+     * --cpu=N        first core to pin threads to, the rest follow round-robin
+     * --peer=N       core of the second process in cross-process benchmarks
+     * --no-pin       leave thread placement to the scheduler
+     */
+    inline Options parse_options(int argc, char** argv) {
+        Options options{};
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg(argv[i]);
+            const auto value = [&](std::string_view key) {
+                return arg.substr(key.size());
+            };
+
+            if (arg.starts_with("--ops=")) {
+                options.ops = std::strtoull(value("--ops=").data(), nullptr, 10);
+            } else if (arg.starts_with("--filter=")) {
+                options.filter = value("--filter=");
+            } else if (arg.starts_with("--out=")) {
+                options.out = value("--out=");
+            } else if (arg.starts_with("--bytes=")) {
+                options.bytes = std::strtoull(value("--bytes=").data(), nullptr, 10);
+            } else if (arg.starts_with("--cpu=")) {
+                options.first_cpu = std::atoi(value("--cpu=").data());
+            } else if (arg.starts_with("--peer=")) {
+                options.peer_cpu = std::atoi(value("--peer=").data());
+            } else if (arg == "--no-pin") {
+                options.pin = false;
+            }
+        }
+        return options;
+    }
+
+    inline int online_cpus() noexcept {
+        return static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    }
+
+    /**
+     * 'cpu' wrapped to the online CPU count, so round-robin numbering works anywhere.
+     */
+    inline conq::Placement on_cpu(int cpu) {
+        return conq::Placement::on(cpu % online_cpus());
+    }
+
+    /**
+     * Pins the calling thread. Pinning failure (e.g. a restricted cpuset) is not fatal
+     * for a benchmark, so it is only reported.
+     */
+    inline bool pin_current_thread(int cpu) {
+        return !on_cpu(cpu).apply().has_value();
+    }
+
+    /**
+     * How two CPUs relate in the cache hierarchy, or "unknown" without sysfs.
+     */
+    inline std::string placement(int a, int b) {
+        const auto topology = conq::Topology::query();
+        if (!topology.has_value()) {
+            return "unknown";
+        }
+        return conq::to_string(topology->relation(a % online_cpus(), b % online_cpus()));
+    }
+
+    inline std::uint64_t now_ns() noexcept {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * Minimal streaming JSON writer: enough for flat objects, nested objects and arrays.
+     * Commas are inserted automatically, keys are expected to be plain identifiers.
+     */
+    class Json final {
+    public:
+        explicit Json(std::ostream& os) : m_os(os) {}
+
+        Json& begin_object(std::string_view key = {}) {
+            prefix(key);
+            m_os << '{';
+            m_first.push_back(true);
+            return *this;
+        }
+
+        Json& end_object() {
+            m_first.pop_back();
+            m_os << '}';
+            return *this;
+        }
+
+        Json& begin_array(std::string_view key = {}) {
+            prefix(key);
+            m_os << '[';
+            m_first.push_back(true);
+            return *this;
+        }
+
+        Json& end_array() {
+            m_first.pop_back();
+            m_os << ']';
+            return *this;
+        }
+
+        Json& field(std::string_view key, std::string_view value) {
+            prefix(key);
+            quote(value);
+            return *this;
+        }
+
+        Json& field(std::string_view key, const char* value) {
+            return field(key, std::string_view(value));
+        }
+
+        Json& field(std::string_view key, bool value) {
+            prefix(key);
+            m_os << (value ? "true" : "false");
+            return *this;
+        }
+
+        Json& field(std::string_view key, double value) {
+            prefix(key);
+            m_os << std::setprecision(6) << value << std::defaultfloat;
+            return *this;
+        }
+
+        template<std::integral I>
+        Json& field(std::string_view key, I value) {
+            prefix(key);
+            m_os << value;
+            return *this;
+        }
+
+        Json& null(std::string_view key) {
+            prefix(key);
+            m_os << "null";
+            return *this;
+        }
+
+    private:
+        void prefix(std::string_view key) {
+            if (!m_first.empty()) {
+                if (!m_first.back()) {
+                    m_os << ',';
+                }
+                m_first.back() = false;
+            }
+            if (!key.empty()) {
+                quote(key);
+                m_os << ':';
+            }
+        }
+
+        void quote(std::string_view text) {
+            m_os << '"';
+            for (const auto c: text) {
+                if (c == '"' || c == '\\') {
+                    m_os << '\\';
+                }
+                m_os << c;
+            }
+            m_os << '"';
+        }
+
+        std::ostream& m_os;
+        std::vector<bool> m_first;
+    };
+
+    inline void write_latency(Json& json, std::string_view key, const metrics::HistogramSnapshot& histogram) {
+        json.begin_object(key)
+                .field("count", histogram.count())
+                .field("min", histogram.min())
+                .field("p50", histogram.percentile(0.50))
+                .field("p99", histogram.percentile(0.99))
+                .field("p999", histogram.percentile(0.999))
+                .field("max", histogram.max())
+                .end_object();
+    }
+
+    inline void write_perf(Json& json, std::string_view key, const perf::PerfData& data) {
+        json.begin_object(key);
+        for (const auto event: perf::ALL_EVENTS) {
+            const auto value = data.get(event);
+            if (value.has_value()) {
+                json.field(perf::to_string(event), value.value());
+            }
+        }
+        json.end_object();
+    }
+
+    inline void write_context(Json& json, const Options& options) {
+        char host[256]{};
+        gethostname(host, sizeof(host) - 1);
+
+        json.begin_object("context")
+                .field("host", std::string_view(host))
+                .field("date", static_cast<std::int64_t>(std::time(nullptr)))
+                .field("cpus", online_cpus())
+                .field("ops", options.ops)
+                .field("pinned", options.pin)
+#ifdef NDEBUG
+                .field("build", "release")
+#else
+                .field("build", "debug")
+#endif
+                .end_object();
+    }
+}
@@ -0,0 +1,239 @@
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "metrics/Histogram.h"
+#include "channel/Channel.h"
+#include "os/Process.h"
+
+namespace {
+    using Histogram = conq::metrics::HistogramSnapshot;
+
+    constexpr std::array<std::size_t, 7> SIZES = {8, 64, 512, 4096, 32 << 10, 256 << 10, 1 << 20};
+
+    /**
+     * Spins briefly before yielding, so a peer on another core is caught without a
+     * syscall while a peer sharing the core still gets to run.
+     */
+    class Backoff final {
+    public:
+        void pause() noexcept {
+            if (m_spins < SPIN_LIMIT) {
+                ++m_spins;
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        void reset() noexcept {
+            m_spins = 0;
+        }
+
+    private:
+        static constexpr int SPIN_LIMIT = 1000;
+        int m_spins{};
+    };
+
+    template<std::size_t N>
+    void write_all(conq::ChannelWriter<N>& writer, std::span<const char> data) {
+        Backoff backoff;
+        std::size_t written{};
+        while (written < data.size()) {
+            const auto n = writer.write(data.subspan(written));
+            written += n;
+            if (n == 0) {
+                backoff.pause();
+            } else {
+                backoff.reset();
+            }
+        }
+    }
+
+    template<std::size_t N>
+    void read_all(conq::ChannelReader<N>& reader, std::span<char> data) {
+        Backoff backoff;
+        std::size_t read{};
+        while (read < data.size()) {
+            const auto n = reader.read(data.subspan(read));
+            read += n;
+            if (n == 0) {
+                backoff.pause();
+            } else {
+                backoff.reset();
+            }
+        }
+    }
+
+    /**
+     * Both processes derive the same schedule from the options, so the child needs no
+     * instructions beyond the data itself.
+     */
+    std::uint64_t round_trips(const conq::bench::Options& options, std::size_t size) {
+        return std::max<std::uint64_t>(10, options.ops / 16 * 64 / std::max<std::size_t>(64, size));
+    }
+
+    std::uint64_t stream_messages(const conq::bench::Options& options, std::size_t size) {
+        return std::max<std::uint64_t>(4, options.bytes / size);
+    }
+
+    struct Result final {
+        std::size_t capacity;
+        std::size_t size;
+        Histogram round_trip{};
+        std::uint64_t stream_bytes{};
+        double stream_seconds{};
+    };
+
+    /**
+     * A ping channel (parent to child) and a pong channel (child to parent), both mapped
+     * before the fork so either side can use them without a rendezvous.
+     */
+    template<std::size_t N>
+    class Link final {
+    public:
+        explicit Link(const std::string& prefix) :
+                m_ping_writer(conq::ChannelWriter<N>::create(prefix + "_ping").value()),
+                m_ping_reader(conq::ChannelReader<N>::open(prefix + "_ping").value()),
+                m_pong_writer(conq::ChannelWriter<N>::create(prefix + "_pong").value()),
+                m_pong_reader(conq::ChannelReader<N>::open(prefix + "_pong").value()) {}
+
+        int child(const conq::bench::Options& options) {
+            std::vector<char> buffer(SIZES.back());
+            for (const auto size: SIZES) {
+                const auto message = std::span{buffer.data(), size};
+                for (std::uint64_t i = 0; i < round_trips(options, size); ++i) {
+                    read_all(m_ping_reader, message);
+                    write_all(m_pong_writer, message);
+                }
+
+                for (std::uint64_t i = 0; i < stream_messages(options, size); ++i) {
+                    read_all(m_ping_reader, message);
+                }
+                write_all(m_pong_writer, std::span<const char>{buffer.data(), 8});
+            }
+            return 0;
+        }
+
+        void parent(const conq::bench::Options& options, std::vector<Result>& results) {
+            std::vector<char> buffer(SIZES.back(), 'x');
+            for (const auto size: SIZES) {
+                auto& result = results.emplace_back(Result{N, size});
+                const auto message = std::span{buffer.data(), size};
+
+                for (std::uint64_t i = 0; i < round_trips(options, size); ++i) {
+                    const auto begin = conq::bench::now_ns();
+                    write_all(m_ping_writer, message);
+                    read_all(m_pong_reader, message);
+                    result.round_trip.record(conq::bench::now_ns() - begin);
+                }
+
+                const auto messages = stream_messages(options, size);
+                const auto begin = std::chrono::steady_clock::now();
+                for (std::uint64_t i = 0; i < messages; ++i) {
+                    write_all(m_ping_writer, message);
+                }
+                read_all(m_pong_reader, std::span{buffer.data(), 8});
+                const auto end = std::chrono::steady_clock::now();
+
+                result.stream_bytes = messages * size;
+                result.stream_seconds = std::chrono::duration<double>(end - begin).count();
+                std::cerr << "capacity " << N << " size " << size
+                          << ": p50 " << result.round_trip.percentile(0.5) << " ns, "
+                          << static_cast<double>(result.stream_bytes) / result.stream_seconds / 1e6 << " MB/s" << std::endl;
+            }
+        }
+
+    private:
+        conq::ChannelWriter<N> m_ping_writer;
+        conq::ChannelReader<N> m_ping_reader;
+        conq::ChannelWriter<N> m_pong_writer;
+        conq::ChannelReader<N> m_pong_reader;
+    };
+
+    template<std::size_t N>
+    bool run(const conq::bench::Options& options, std::vector<Result>& results) {
+        Link<N> link("/conq_bench_" + std::to_string(getpid()));
+        const auto placement = options.pin ? conq::bench::on_cpu(options.peer_cpu) : conq::Placement{};
+        auto process = conq::Process::fork(placement, [&] {
+            return link.child(options);
+        });
+        if (!process.has_value()) {
+            std::cerr << "fork failed" << std::endl;
+            return false;
+        }
+
+        link.parent(options, results);
+        const auto status = process->wait();
+        if (status.has_value() && status.value() == conq::Process::PLACEMENT_FAILED) {
+            std::cerr << "cannot place the peer on cpu " << options.peer_cpu << std::endl;
+        }
+        return status.has_value() && status.value() == 0;
+    }
+
+    void write(std::ostream& os, const conq::bench::Options& options, const std::vector<Result>& results) {
+        conq::bench::Json json(os);
+        json.begin_object();
+        conq::bench::write_context(json, options);
+        json.begin_object("placement")
+                .field("cpu", options.first_cpu)
+                .field("peer", options.peer_cpu)
+                .field("relation", options.pin ? conq::bench::placement(options.first_cpu, options.peer_cpu) : "unpinned")
+                .end_object();
+        json.begin_array("benchmarks");
+        for (const auto& result: results) {
+            json.begin_object()
+                    .field("name", "channel/cap" + std::to_string(result.capacity) + "/" + std::to_string(result.size) + "B")
+                    .field("capacity", result.capacity)
+                    .field("message_size", result.size);
+            conq::bench::write_latency(json, "round_trip_ns", result.round_trip);
+            json.field("stream_bytes", result.stream_bytes)
+                    .field("stream_seconds", result.stream_seconds)
+                    .field("bandwidth_mb_per_sec", static_cast<double>(result.stream_bytes) / result.stream_seconds / 1e6)
+                    .end_object();
+        }
+        json.end_array();
+        json.end_object();
+        os << std::endl;
+    }
+}
+
+/**
+ * Round-trip latency and streaming bandwidth of ChannelWriter/ChannelReader between
+ * two processes. Run it once per placement of interest, e.g. --cpu=0 --peer=0 (same
+ * core), an SMT sibling, a core on the same socket and one across sockets; the
+ * relation is detected from sysfs and recorded in the output.
+ */
+int main(int argc, char** argv) {
+    const auto options = conq::bench::parse_options(argc, argv);
+
+    if (options.pin) {
+        conq::bench::pin_current_thread(options.first_cpu);
+    }
+
+    std::vector<Result> results;
+    if (!run<64>(options, results) || !run<4096>(options, results)) {
+        std::cerr << "peer process failed" << std::endl;
+        return 1;
+    }
+
+    if (options.out.empty()) {
+        write(std::cout, options, results);
+        return 0;
+    }
+
+    std::ofstream file(options.out);
+    if (!file) {
+        std::cerr << "cannot open " << options.out << std::endl;
+        return 1;
+    }
+    write(file, options, results);
+    return 0;
+}
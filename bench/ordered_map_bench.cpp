@@ -0,0 +1,300 @@
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "metrics/Histogram.h"
+#include "Rcu.h"
+#include "SkipList.h"
+
+namespace {
+    using Histogram = conq::metrics::HistogramSnapshot;
+
+    constexpr long KEYS = 4096;
+    constexpr long SCAN = 16;
+
+    /**
+     * Percentages of lookups, inserts, erases and short range scans; the rest of 100.
+     */
+    struct Mix final {
+        std::string name;
+        int find;
+        int insert;
+        int erase;
+    };
+
+    struct Config final {
+        std::string map;
+        Mix mix;
+        int threads;
+    };
+
+    struct Result final {
+        Config config;
+        std::uint64_t ops{};
+        double seconds{};
+        Histogram latency{};
+    };
+
+    /**
+     * The baseline the skip list replaces: one mutex around a std::map.
+     */
+    class LockedMap final {
+    public:
+        struct Session final {
+            void quiescent() noexcept {}
+        };
+
+        Session session() noexcept {
+            return {};
+        }
+
+        bool find(long key) {
+            std::lock_guard lock(m_mutex);
+            return m_map.contains(key);
+        }
+
+        void insert(Session&, long key, long value) {
+            std::lock_guard lock(m_mutex);
+            m_map.emplace(key, value);
+        }
+
+        void erase(long key) {
+            std::lock_guard lock(m_mutex);
+            m_map.erase(key);
+        }
+
+        long range(long from, long to) {
+            std::lock_guard lock(m_mutex);
+            long sum = 0;
+            for (auto it = m_map.lower_bound(from); it != m_map.end() && it->first < to; ++it) {
+                sum += it->second;
+            }
+            return sum;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::map<long, long> m_map;
+    };
+
+    class LockFreeMap final {
+    public:
+        using List = conq::SkipList<long, long, 4 * KEYS>;
+
+        struct Session final {
+            std::optional<conq::RcuDomain<>::Reader> reader;
+
+            void quiescent() noexcept {
+                reader->quiescent();
+            }
+        };
+
+        Session session() {
+            return Session{m_domain.register_reader()};
+        }
+
+        bool find(long key) const {
+            return m_list->contains(key);
+        }
+
+        /**
+         * Exhausted only while erased nodes wait out their grace period, which includes
+         * this thread's own quiescent point, so pass one before each retry.
+         */
+        void insert(Session& session, long key, long value) {
+            while (!m_list->insert(key, value).has_value()) {
+                session.quiescent();
+                std::this_thread::yield();
+            }
+        }
+
+        void erase(long key) {
+            (void) m_list->erase(key);
+        }
+
+        long range(long from, long to) const {
+            long sum = 0;
+            m_list->range(from, to, [&](long, long value) { sum += value; });
+            return sum;
+        }
+
+    private:
+        conq::RcuDomain<> m_domain{};
+        std::unique_ptr<List> m_list = std::make_unique<List>(m_domain);
+    };
+
+    struct alignas (conq::CACHE_LINE_SIZE) ThreadStats final {
+        Histogram latency{};
+        long sink{};
+    };
+
+    /**
+     * Half the key space is filled up front; each thread then runs its share of 'ops'
+     * operations on uniformly random keys, timing each one. Inserts and erases balance,
+     * so the map stays around half full.
+     */
+    template<typename M>
+    void run(M& map, const conq::bench::Options& options, Result& result) {
+        const auto& config = result.config;
+        const auto per_thread = options.ops / static_cast<std::uint64_t>(config.threads);
+        {
+            auto session = map.session();
+            for (long key = 0; key < KEYS; key += 2) {
+                map.insert(session, key, key);
+            }
+        }
+
+        std::vector<std::unique_ptr<ThreadStats>> stats;
+        for (int i = 0; i < config.threads; ++i) {
+            stats.push_back(std::make_unique<ThreadStats>());
+        }
+
+        std::atomic<int> ready = 0;
+        std::atomic<bool> go = false;
+        const auto worker = [&](int id) {
+            if (options.pin) {
+                conq::bench::pin_current_thread(options.first_cpu + id);
+            }
+            auto& own = *stats[static_cast<std::size_t>(id)];
+            auto session = map.session();
+            auto rng = static_cast<std::uint32_t>(id * 2654435761u + 1);
+
+            ready.fetch_add(1, std::memory_order_release);
+            go.wait(false, std::memory_order_acquire);
+            for (std::uint64_t i = 0; i < per_thread; ++i) {
+                rng ^= rng << 13;
+                rng ^= rng >> 17;
+                rng ^= rng << 5;
+                const auto key = static_cast<long>(rng % KEYS);
+                const auto dice = static_cast<int>(rng >> 16) % 100;
+
+                const auto begin = conq::bench::now_ns();
+                if (dice < config.mix.find) {
+                    own.sink += map.find(key);
+                } else if (dice < config.mix.find + config.mix.insert) {
+                    map.insert(session, key, key);
+                } else if (dice < config.mix.find + config.mix.insert + config.mix.erase) {
+                    map.erase(key);
+                } else {
+                    own.sink += map.range(key, key + SCAN);
+                }
+                own.latency.record(conq::bench::now_ns() - begin);
+                session.quiescent();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < config.threads; ++i) {
+            workers.emplace_back(worker, i);
+        }
+        while (ready.load(std::memory_order_acquire) != config.threads) {
+            std::this_thread::yield();
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        go.notify_all();
+        for (auto& thread: workers) {
+            thread.join();
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        result.ops = per_thread * static_cast<std::uint64_t>(config.threads);
+        result.seconds = std::chrono::duration<double>(end - begin).count();
+        for (const auto& own: stats) {
+            result.latency.merge(own->latency);
+        }
+    }
+
+    class Suite final {
+    public:
+        explicit Suite(const conq::bench::Options& options) : m_options(options) {}
+
+        template<typename M>
+        void add(Config config) {
+            const auto name = to_name(config);
+            if (!m_options.filter.empty() && name.find(m_options.filter) == std::string::npos) {
+                return;
+            }
+
+            auto map = std::make_unique<M>();
+            auto& result = m_results.emplace_back();
+            result.config = std::move(config);
+            run(*map, m_options, result);
+            std::cerr << name << ": " << static_cast<std::uint64_t>(static_cast<double>(result.ops) / result.seconds)
+                      << " ops/s" << std::endl;
+        }
+
+        void write(std::ostream& os) const {
+            conq::bench::Json json(os);
+            json.begin_object();
+            conq::bench::write_context(json, m_options);
+            json.begin_array("benchmarks");
+            for (const auto& result: m_results) {
+                const auto& config = result.config;
+                json.begin_object()
+                        .field("name", to_name(config))
+                        .field("map", config.map)
+                        .field("mix", config.mix.name)
+                        .field("threads", config.threads)
+                        .field("keys", KEYS)
+                        .field("ops", result.ops)
+                        .field("seconds", result.seconds)
+                        .field("ops_per_sec", static_cast<double>(result.ops) / result.seconds);
+                conq::bench::write_latency(json, "op_ns", result.latency);
+                json.end_object();
+            }
+            json.end_array();
+            json.end_object();
+            os << std::endl;
+        }
+
+    private:
+        static std::string to_name(const Config& config) {
+            return config.map + "/" + config.mix.name + "/t" + std::to_string(config.threads);
+        }
+
+        const conq::bench::Options& m_options;
+        std::vector<Result> m_results;
+    };
+}
+
+int main(int argc, char** argv) {
+    const auto options = conq::bench::parse_options(argc, argv);
+
+    const Mix mixes[] = {
+            {"read90", 90, 4, 4},
+            {"write50", 50, 25, 25},
+            {"scan", 40, 10, 10},
+    };
+
+    Suite suite(options);
+    for (const auto& mix: mixes) {
+        for (const int threads: {1, 2, 4, 8}) {
+            suite.add<LockedMap>({"mutex+std::map", mix, threads});
+            suite.add<LockFreeMap>({"SkipList", mix, threads});
+        }
+    }
+
+    if (options.out.empty()) {
+        suite.write(std::cout);
+        return 0;
+    }
+
+    std::ofstream file(options.out);
+    if (!file) {
+        std::cerr << "cannot open " << options.out << std::endl;
+        return 1;
+    }
+    suite.write(file);
+    return 0;
+}
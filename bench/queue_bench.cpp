@@ -0,0 +1,308 @@
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "metrics/Histogram.h"
+#include "LockFreeStack.h"
+#include "MPMC.h"
+#include "MPSCBoundedQueue.h"
+#include "SPSC.h"
+#include "SPSCBoundedQueue.h"
+#include "os/perf/Perf.h"
+
+namespace {
+    using Histogram = conq::metrics::HistogramSnapshot;
+
+    template<std::size_t SIZE>
+    struct Payload final {
+        std::uint64_t sequence{};
+        std::array<std::byte, SIZE - sizeof(std::uint64_t)> padding{};
+    };
+
+    template<typename Q, typename T>
+    bool push(Q& queue, T value) {
+        if constexpr (requires { queue.try_push(value); }) {
+            return queue.try_push(std::move(value));
+        } else {
+            queue.push(std::move(value));
+            return true;
+        }
+    }
+
+    template<typename Q>
+    auto pop(Q& queue) {
+        if constexpr (requires { queue.try_pop(); }) {
+            return queue.try_pop();
+        } else {
+            return queue.pop();
+        }
+    }
+
+    struct Config final {
+        std::string queue;
+        int producers;
+        int consumers;
+        std::size_t capacity;
+        std::size_t element_size;
+    };
+
+    struct Result final {
+        Config config;
+        std::uint64_t ops{};
+        double seconds{};
+        Histogram push_latency{};
+        Histogram pop_latency{};
+        std::uint64_t push_failures{};
+        std::uint64_t pop_failures{};
+        conq::perf::PerfData perf{};
+    };
+
+    struct alignas (conq::CACHE_LINE_SIZE) ThreadStats final {
+        Histogram latency{};
+        std::uint64_t failures{};
+    };
+
+    /**
+     * Producers push 'ops' elements in total, consumers pop until all of them are
+     * drained. Each successful operation is timed individually; rejected attempts
+     * (queue full / empty) are counted and retried after a yield, which keeps
+     * oversubscribed runs (more threads than cores) from live-locking.
+     */
+    template<typename Q, typename T>
+    void run(Q& queue, const conq::bench::Options& options, Result& result) {
+        const auto& config = result.config;
+        const auto threads = config.producers + config.consumers;
+        const auto per_producer = options.ops / static_cast<std::uint64_t>(config.producers);
+        const auto total = per_producer * static_cast<std::uint64_t>(config.producers);
+
+        std::vector<std::unique_ptr<ThreadStats>> stats;
+        for (int i = 0; i < threads; ++i) {
+            stats.push_back(std::make_unique<ThreadStats>());
+        }
+
+        std::atomic<int> ready = 0;
+        std::atomic<bool> go = false;
+        std::atomic<std::uint64_t> consumed = 0;
+
+        const auto prologue = [&](int id) {
+            if (options.pin) {
+                conq::bench::pin_current_thread(options.first_cpu + id);
+            }
+            ready.fetch_add(1, std::memory_order_release);
+            go.wait(false, std::memory_order_acquire);
+        };
+
+        const auto producer = [&](int id) {
+            prologue(id);
+            auto& own = *stats[static_cast<std::size_t>(id)];
+            for (std::uint64_t i = 0; i < per_producer; ++i) {
+                T value{};
+                value.sequence = i;
+                while (true) {
+                    const auto begin = conq::bench::now_ns();
+                    const auto pushed = push(queue, value);
+                    const auto end = conq::bench::now_ns();
+                    if (pushed) {
+                        own.latency.record(end - begin);
+                        break;
+                    }
+                    ++own.failures;
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        const auto consumer = [&](int id) {
+            prologue(id);
+            auto& own = *stats[static_cast<std::size_t>(id)];
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                const auto begin = conq::bench::now_ns();
+                const auto value = pop(queue);
+                const auto end = conq::bench::now_ns();
+                if (value.has_value()) {
+                    own.latency.record(end - begin);
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                ++own.failures;
+                std::this_thread::yield();
+            }
+        };
+
+        // Inherited counters only follow threads created after they are enabled.
+        auto perf = conq::perf::Perf::open(conq::perf::Target::inherited());
+        if (perf.has_value()) {
+            perf->start();
+        }
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < config.producers; ++i) {
+            workers.emplace_back(producer, i);
+        }
+        for (int i = 0; i < config.consumers; ++i) {
+            workers.emplace_back(consumer, config.producers + i);
+        }
+        while (ready.load(std::memory_order_acquire) != threads) {
+            std::this_thread::yield();
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        go.notify_all();
+        for (auto& worker: workers) {
+            worker.join();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        if (perf.has_value()) {
+            perf->stop();
+            result.perf = perf->read();
+        }
+
+        result.ops = total;
+        result.seconds = std::chrono::duration<double>(end - begin).count();
+        for (int i = 0; i < threads; ++i) {
+            const auto& own = *stats[static_cast<std::size_t>(i)];
+            if (i < config.producers) {
+                result.push_latency.merge(own.latency);
+                result.push_failures += own.failures;
+            } else {
+                result.pop_latency.merge(own.latency);
+                result.pop_failures += own.failures;
+            }
+        }
+    }
+
+    class Suite final {
+    public:
+        explicit Suite(const conq::bench::Options& options) : m_options(options) {}
+
+        /**
+         * Runs the benchmark unless it is filtered out. 'make' builds a fresh queue,
+         * heap-allocated since bounded queues of large payloads do not fit on a stack.
+         */
+        template<typename T, typename Make>
+        void add(Config config, Make make) {
+            const auto name = to_name(config);
+            if (!m_options.filter.empty() && name.find(m_options.filter) == std::string::npos) {
+                return;
+            }
+
+            auto queue = make();
+            auto& result = m_results.emplace_back();
+            result.config = std::move(config);
+            run<std::remove_reference_t<decltype(*queue)>, T>(*queue, m_options, result);
+            std::cerr << name << ": " << static_cast<std::uint64_t>(static_cast<double>(result.ops) / result.seconds)
+                      << " ops/s" << std::endl;
+        }
+
+        void write(std::ostream& os) const {
+            conq::bench::Json json(os);
+            json.begin_object();
+            conq::bench::write_context(json, m_options);
+            json.begin_array("benchmarks");
+            for (const auto& result: m_results) {
+                const auto& config = result.config;
+                json.begin_object()
+                        .field("name", to_name(config))
+                        .field("queue", config.queue)
+                        .field("producers", config.producers)
+                        .field("consumers", config.consumers)
+                        .field("capacity", config.capacity)
+                        .field("element_size", config.element_size)
+                        .field("ops", result.ops)
+                        .field("seconds", result.seconds)
+                        .field("ops_per_sec", static_cast<double>(result.ops) / result.seconds)
+                        .field("push_failures", result.push_failures)
+                        .field("pop_failures", result.pop_failures);
+                conq::bench::write_latency(json, "push_ns", result.push_latency);
+                conq::bench::write_latency(json, "pop_ns", result.pop_latency);
+                conq::bench::write_perf(json, "perf", result.perf);
+                json.end_object();
+            }
+            json.end_array();
+            json.end_object();
+            os << std::endl;
+        }
+
+    private:
+        static std::string to_name(const Config& config) {
+            return config.queue
+                   + "/p" + std::to_string(config.producers)
+                   + "c" + std::to_string(config.consumers)
+                   + "/cap" + std::to_string(config.capacity)
+                   + "/" + std::to_string(config.element_size) + "B";
+        }
+
+        const conq::bench::Options& m_options;
+        std::vector<Result> m_results;
+    };
+
+    template<std::size_t SIZE, std::size_t CAPACITY>
+    void bounded(Suite& suite) {
+        using T = Payload<SIZE>;
+
+        suite.add<T>({"SPSCMailBox", 1, 1, CAPACITY, SIZE}, [] {
+            return std::make_unique<conq::SPSCMailBox<T, CAPACITY>>();
+        });
+        for (const int producers: {1, 2, 4}) {
+            suite.add<T>({"MPSCBoundedQueue", producers, 1, CAPACITY, SIZE}, [] {
+                return std::make_unique<conq::MPSCBoundedQueue<T, CAPACITY>>();
+            });
+        }
+        for (const int threads: {1, 2, 4}) {
+            suite.add<T>({"MPMCBoundedQueue", threads, threads, CAPACITY, SIZE}, [] {
+                return std::make_unique<conq::MPMCBoundedQueue<T, CAPACITY>>();
+            });
+        }
+    }
+
+    template<std::size_t SIZE>
+    void unbounded(Suite& suite) {
+        using T = Payload<SIZE>;
+
+        suite.add<T>({"SPSCQueue", 1, 1, 0, SIZE}, [] {
+            return std::make_unique<conq::SPSCQueue<T>>();
+        });
+        for (const int threads: {1, 2, 4}) {
+            suite.add<T>({"LockFreeStack", threads, threads, 0, SIZE}, [] {
+                return std::make_unique<conq::LockFreeStack<T>>();
+            });
+        }
+    }
+
+    template<std::size_t SIZE>
+    void sized(Suite& suite) {
+        bounded<SIZE, 64>(suite);
+        bounded<SIZE, 1024>(suite);
+        unbounded<SIZE>(suite);
+    }
+}
+
+int main(int argc, char** argv) {
+    const auto options = conq::bench::parse_options(argc, argv);
+
+    Suite suite(options);
+    sized<8>(suite);
+    sized<64>(suite);
+    sized<256>(suite);
+
+    if (options.out.empty()) {
+        suite.write(std::cout);
+        return 0;
+    }
+
+    std::ofstream file(options.out);
+    if (!file) {
+        std::cerr << "cannot open " << options.out << std::endl;
+        return 1;
+    }
+    suite.write(file);
+    return 0;
+}
@@ -0,0 +1,499 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Definitions.h"
+#include "Rcu.h"
+#include "SeqLock.h"
+
+namespace conq {
+    namespace detail {
+        /**
+         * Bit i set where byte i of 'word' equals 'tag'. Exact: no borrow runs across
+         * bytes.
+         */
+        inline std::uint32_t match_word(std::uint64_t word, std::uint8_t tag) noexcept {
+            constexpr std::uint64_t LOW = 0x7f7f7f7f7f7f7f7f;
+            const auto x = word ^ (0x0101010101010101 * static_cast<std::uint64_t>(tag));
+            const auto zero = ~(((x & LOW) + LOW) | x | LOW);
+            // Gathers the high bit of every byte into the top byte.
+            return static_cast<std::uint32_t>(((zero >> 7) * 0x0102040810204080) >> 56);
+        }
+
+        /**
+         * Bit i set where tag i of the 16 tags in 'lo' and 'hi' equals 'tag'; one
+         * compare and movemask with SSE2.
+         */
+        inline std::uint32_t match_tags(std::uint64_t lo, std::uint64_t hi, std::uint8_t tag) noexcept {
+#if defined(__SSE2__)
+            const auto tags = _mm_set_epi64x(static_cast<long long>(hi), static_cast<long long>(lo));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+            return match_word(lo, tag) | match_word(hi, tag) << 8;
+#endif
+        }
+    }
+
+    /**
+     * Open-addressing hash map whose lookups take no lock and write nothing, so they
+     * scale with the number of reading cores. Buckets of 16 slots are probed linearly;
+     * each bucket keeps a version and 16 one-byte tags (7 hash bits) on its first cache
+     * line, so a lookup matches all tags with one SIMD compare and touches only the
+     * slots whose tag matches, under a per-bucket seqlock.
+     *
+     * Writers take one of STRIPES mutexes picked by the key's hash, which orders all
+     * writes to a key, and lock the buckets they modify through the bucket version.
+     * Past 3/4 occupancy the map moves to a new table incrementally: every write
+     * migrates a few buckets until none are left, and the old table is freed through
+     * the RCU domain once no thread can still see it.
+     *
+     * Every thread that uses the map, writers included, must be an online reader of
+     * 'domain' and pass quiescent points regularly. K and V are copied word by word,
+     * so both must be trivially copyable.
+     */
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Domain = RcuDomain<>>
+    requires std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V> &&
+             std::is_default_constructible_v<K> && std::is_default_constructible_v<V> &&
+             std::equality_comparable<K>
+    class ConcurrentHashMap final {
+    private:
+        static constexpr std::size_t SLOTS = 16;
+        static constexpr std::size_t STRIPES = 64;
+        static constexpr std::size_t MIGRATE_CHUNK = 8;
+
+        static constexpr std::uint8_t EMPTY = 0;
+        static constexpr std::uint8_t TOMBSTONE = 1;
+        static constexpr std::uint8_t LIVE = 0x80;
+
+        /** Bucket version of a bucket copied to the next table; odd, so writers stay out. */
+        static constexpr std::uint64_t MOVED = ~std::uint64_t{0};
+
+        struct Entry {
+            detail::AtomicWords<K> key{};
+            detail::AtomicWords<V> value{};
+        };
+
+        struct alignas (CACHE_LINE_SIZE) Bucket {
+            std::atomic<std::uint64_t> version{};
+            std::array<std::atomic<std::uint64_t>, 2> tags{};
+            alignas (CACHE_LINE_SIZE) std::array<Entry, SLOTS> entries{};
+
+            [[nodiscard]]
+            std::uint32_t match(std::uint8_t tag) const noexcept {
+                return detail::match_tags(tags[0].load(std::memory_order_relaxed), tags[1].load(std::memory_order_relaxed), tag);
+            }
+
+            void set_tag(std::size_t slot, std::uint8_t tag) noexcept {
+                auto& word = tags[slot / 8];
+                const auto shift = 8 * (slot % 8);
+                const auto bits = word.load(std::memory_order_relaxed) & ~(std::uint64_t{0xff} << shift);
+                word.store(bits | static_cast<std::uint64_t>(tag) << shift, std::memory_order_relaxed);
+            }
+        };
+
+        struct Table {
+            explicit Table(std::size_t buckets) :
+                    buckets(buckets),
+                    slots(std::make_unique<Bucket[]>(buckets)) {}
+
+            [[nodiscard]]
+            std::size_t capacity() const noexcept {
+                return buckets * SLOTS;
+            }
+
+            const std::size_t buckets;
+            const std::unique_ptr<Bucket[]> slots;
+            /** Live and tombstoned slots. */
+            std::atomic<std::size_t> used{};
+            /** Set while this table is migrated into a bigger (or cleaner) one. */
+            std::atomic<Table*> next{};
+            std::atomic<std::size_t> cursor{};
+            std::atomic<std::size_t> moved{};
+        };
+
+        struct alignas (CACHE_LINE_SIZE) Stripe {
+            std::mutex mutex;
+        };
+
+        enum class Hit {
+            Found,
+            Missing,
+            Moved,
+        };
+
+        struct Probe {
+            Hit hit{};
+            /** The bucket has an empty slot, so the key cannot be further along. */
+            bool last{};
+            std::size_t slot{};
+            V value{};
+        };
+
+        enum class Outcome {
+            Inserted,
+            Assigned,
+            Present,
+            Erased,
+            Missing,
+            Retry,
+        };
+
+        enum class Op {
+            Insert,
+            Assign,
+            Erase,
+        };
+
+    public:
+        /**
+         * Room for at least 'capacity' elements before the first resize.
+         */
+        explicit ConcurrentHashMap(Domain& domain, std::size_t capacity = 1024) :
+                m_domain(&domain),
+                m_table(new Table(std::bit_ceil(std::max<std::size_t>(capacity * 4 / 3 / SLOTS + 1, 2)))) {}
+
+        ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+        ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+        /**
+         * No thread may still use the map.
+         */
+        ~ConcurrentHashMap() {
+            const auto table = m_table.load(std::memory_order_relaxed);
+            delete table->next.load(std::memory_order_relaxed);
+            delete table;
+        }
+
+    public:
+        [[nodiscard]]
+        std::optional<V> find(const K& key) const noexcept {
+            const auto hash = hash_of(key);
+            for (auto table = m_table.load(std::memory_order_acquire); table != nullptr;) {
+                bool moved = false;
+                for (std::size_t i = 0, index = home(*table, hash); i < table->buckets; ++i, index = (index + 1) & (table->buckets - 1)) {
+                    const auto probe = probe_bucket(table->slots[index], key, tag_of(hash));
+                    if (probe.hit == Hit::Found) {
+                        return probe.value;
+                    }
+                    moved |= probe.hit == Hit::Moved;
+                    if (probe.last) {
+                        break;
+                    }
+                }
+
+                // Buckets already moved on were skipped; the key may be in the next table.
+                if (!moved) {
+                    return std::nullopt;
+                }
+                table = table->next.load(std::memory_order_acquire);
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]]
+        bool contains(const K& key) const noexcept {
+            return find(key).has_value();
+        }
+
+        /**
+         * Inserts unless 'key' is present; returns true if it inserted.
+         */
+        bool insert(const K& key, const V& value) {
+            return modify(key, Op::Insert, value) == Outcome::Inserted;
+        }
+
+        /**
+         * Inserts or overwrites; returns true if it inserted.
+         */
+        bool insert_or_assign(const K& key, const V& value) {
+            return modify(key, Op::Assign, value) == Outcome::Inserted;
+        }
+
+        bool erase(const K& key) {
+            return modify(key, Op::Erase, V{}) == Outcome::Erased;
+        }
+
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            return m_size.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        std::size_t capacity() const noexcept {
+            return m_table.load(std::memory_order_acquire)->capacity();
+        }
+
+        /**
+         * A migration to a new table is in progress.
+         */
+        [[nodiscard]]
+        bool resizing() const noexcept {
+            return m_table.load(std::memory_order_acquire)->next.load(std::memory_order_acquire) != nullptr;
+        }
+
+    private:
+        static std::uint64_t hash_of(const K& key) noexcept {
+            // Finaliser of MurmurHash3: std::hash of an integer is the identity.
+            auto hash = static_cast<std::uint64_t>(Hash{}(key));
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccd;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        static std::uint8_t tag_of(std::uint64_t hash) noexcept {
+            return static_cast<std::uint8_t>(LIVE | hash >> 57);
+        }
+
+        static std::size_t home(const Table& table, std::uint64_t hash) noexcept {
+            return static_cast<std::size_t>(hash) & (table.buckets - 1);
+        }
+
+        /**
+         * Consistent look at one bucket, retried while a writer holds it.
+         */
+        static Probe probe_bucket(const Bucket& bucket, const K& key, std::uint8_t tag) noexcept {
+            while (true) {
+                const auto before = bucket.version.load(std::memory_order_acquire);
+                if (before == MOVED) {
+                    // Tags are frozen once moved; only the chain end is still of use.
+                    return Probe{Hit::Moved, bucket.match(EMPTY) != 0};
+                }
+                if (before & 1) {
+                    cpu_relax();
+                    continue;
+                }
+
+                Probe probe{Hit::Missing, bucket.match(EMPTY) != 0};
+                for (auto matches = bucket.match(tag); matches != 0; matches &= matches - 1) {
+                    const auto slot = static_cast<std::size_t>(std::countr_zero(matches));
+                    if (bucket.entries[slot].key.load() == key) {
+                        probe = Probe{Hit::Found, true, slot, bucket.entries[slot].value.load()};
+                        break;
+                    }
+                }
+
+                // Keeps the slot loads above the second version read.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (bucket.version.load(std::memory_order_relaxed) == before) {
+                    return probe;
+                }
+            }
+        }
+
+        /**
+         * Takes the bucket for writing; false once it has moved to the next table.
+         */
+        static bool lock_bucket(Bucket& bucket) noexcept {
+            while (true) {
+                // Acquire: a caller finding the bucket moved reads its frozen tags.
+                auto version = bucket.version.load(std::memory_order_acquire);
+                if (version == MOVED) {
+                    return false;
+                }
+                if ((version & 1) == 0 && bucket.version.compare_exchange_weak(version, version + 1, std::memory_order_acquire)) {
+                    // Keeps the slot stores below the odd version.
+                    std::atomic_thread_fence(std::memory_order_release);
+                    return true;
+                }
+                cpu_relax();
+            }
+        }
+
+        static void unlock_bucket(Bucket& bucket) noexcept {
+            bucket.version.store(bucket.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        Outcome modify(const K& key, Op op, const V& value) {
+            const auto hash = hash_of(key);
+            std::lock_guard lock(m_stripes[hash & (STRIPES - 1)].mutex);
+            while (true) {
+                auto table = m_table.load(std::memory_order_acquire);
+                if (const auto next = table->next.load(std::memory_order_acquire); next != nullptr) {
+                    // The key's old copy, if any, must reach the next table first.
+                    migrate_chain(*table, *next, hash);
+                    help_migrate(*table, *next);
+                    table = next;
+                }
+
+                const auto outcome = apply(*table, key, hash, op, value);
+                if (outcome != Outcome::Retry) {
+                    if (outcome == Outcome::Inserted && table->used.load(std::memory_order_relaxed) * 4 > table->capacity() * 3) {
+                        start_resize(*table);
+                    }
+                    return outcome;
+                }
+            }
+        }
+
+        Outcome apply(Table& table, const K& key, std::uint64_t hash, Op op, const V& value) {
+            const auto mask = table.buckets - 1;
+            const auto tag = tag_of(hash);
+            for (std::size_t i = 0, index = home(table, hash); i < table.buckets; ++i, index = (index + 1) & mask) {
+                auto& bucket = table.slots[index];
+                const auto probe = probe_bucket(bucket, key, tag);
+                if (probe.hit == Hit::Moved) {
+                    return Outcome::Retry;
+                }
+                if (probe.hit == Hit::Found) {
+                    if (op == Op::Insert) {
+                        return Outcome::Present;
+                    }
+                    // Only this stripe changes the key's slot, so it is still there
+                    // unless the bucket has moved since.
+                    if (!lock_bucket(bucket)) {
+                        return Outcome::Retry;
+                    }
+                    if (op == Op::Assign) {
+                        bucket.entries[probe.slot].value.store(value);
+                    } else {
+                        bucket.set_tag(probe.slot, TOMBSTONE);
+                        m_size.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                    unlock_bucket(bucket);
+                    return op == Op::Assign ? Outcome::Assigned : Outcome::Erased;
+                }
+                if (probe.last) {
+                    break;
+                }
+            }
+
+            if (op == Op::Erase) {
+                return Outcome::Missing;
+            }
+            if (const auto placed = place(table, key, hash, value); !placed.has_value()) {
+                return Outcome::Retry;
+            } else if (!placed.value()) {
+                // Full of tombstones: rebuild the table and try there.
+                start_resize(table);
+                return Outcome::Retry;
+            }
+            m_size.fetch_add(1, std::memory_order_relaxed);
+            return Outcome::Inserted;
+        }
+
+        /**
+         * Stores a key known to be absent in the first free slot of its chain. nullopt
+         * when it met a moved bucket, false when no slot was free.
+         */
+        static std::optional<bool> place(Table& table, const K& key, std::uint64_t hash, const V& value) noexcept {
+            const auto mask = table.buckets - 1;
+            for (std::size_t i = 0, index = home(table, hash); i < table.buckets; ++i, index = (index + 1) & mask) {
+                auto& bucket = table.slots[index];
+                if (!lock_bucket(bucket)) {
+                    return std::nullopt;
+                }
+
+                const auto empty = bucket.match(EMPTY);
+                const auto free = empty | bucket.match(TOMBSTONE);
+                if (free != 0) {
+                    const auto slot = static_cast<std::size_t>(std::countr_zero(free));
+                    bucket.entries[slot].key.store(key);
+                    bucket.entries[slot].value.store(value);
+                    bucket.set_tag(slot, tag_of(hash));
+                    unlock_bucket(bucket);
+                    if ((empty >> slot & 1) != 0) {
+                        table.used.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return true;
+                }
+                unlock_bucket(bucket);
+            }
+            return false;
+        }
+
+        void start_resize(Table& table) {
+            std::lock_guard lock(m_resize);
+            if (m_table.load(std::memory_order_relaxed) != &table || table.next.load(std::memory_order_relaxed) != nullptr) {
+                return;
+            }
+
+            // Mostly live: double. Mostly tombstones: rebuild at the same size.
+            const auto live = m_size.load(std::memory_order_relaxed);
+            const auto buckets = live * 8 > table.capacity() * 3 ? table.buckets * 2 : table.buckets;
+            table.next.store(new Table(buckets), std::memory_order_release);
+        }
+
+        /**
+         * Copies the bucket's live slots into 'to' and marks it moved; returns once it
+         * has moved, whoever moved it.
+         */
+        void migrate_bucket(Table& from, Table& to, std::size_t index) noexcept {
+            auto& bucket = from.slots[index];
+            if (!lock_bucket(bucket)) {
+                return;
+            }
+
+            for (auto live = ~(bucket.match(EMPTY) | bucket.match(TOMBSTONE)) & 0xffff; live != 0; live &= live - 1) {
+                const auto& entry = bucket.entries[static_cast<std::size_t>(std::countr_zero(live))];
+                const auto key = entry.key.load();
+                // 'to' is not resized before 'from' is retired, so this always succeeds.
+                (void) place(to, key, hash_of(key), entry.value.load());
+            }
+
+            bucket.version.store(MOVED, std::memory_order_release);
+            from.moved.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        /**
+         * Moves the buckets a key with 'hash' may occupy in 'from': its home bucket up
+         * to the first one with an empty slot.
+         */
+        void migrate_chain(Table& from, Table& to, std::uint64_t hash) {
+            const auto mask = from.buckets - 1;
+            for (std::size_t i = 0, index = home(from, hash); i < from.buckets; ++i, index = (index + 1) & mask) {
+                migrate_bucket(from, to, index);
+                if (from.slots[index].match(EMPTY) != 0) {
+                    break;
+                }
+            }
+            finish_resize(from, to);
+        }
+
+        void help_migrate(Table& from, Table& to) {
+            const auto start = from.cursor.fetch_add(MIGRATE_CHUNK, std::memory_order_relaxed);
+            for (auto index = start; index < std::min(start + MIGRATE_CHUNK, from.buckets); ++index) {
+                migrate_bucket(from, to, index);
+            }
+            finish_resize(from, to);
+        }
+
+        void finish_resize(Table& from, Table& to) {
+            if (from.moved.load(std::memory_order_acquire) != from.buckets) {
+                return;
+            }
+
+            std::lock_guard lock(m_resize);
+            if (m_table.load(std::memory_order_relaxed) != &from) {
+                return;
+            }
+            m_table.store(&to, std::memory_order_release);
+            // Readers may still be walking 'from' and following its 'next'.
+            const auto old = &from;
+            m_domain->call_rcu([old]() { delete old; });
+            (void) m_domain->reclaim();
+        }
+
+        Domain* m_domain;
+        alignas (CACHE_LINE_SIZE) std::atomic<Table*> m_table;
+        alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_size{};
+        std::array<Stripe, STRIPES> m_stripes{};
+        std::mutex m_resize;
+    };
+}
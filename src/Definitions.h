@@ -14,4 +14,13 @@ namespace conq {
     }
 
     constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    /** Spin-wait hint: lets the sibling hyperthread run and saves power while polling. */
+    inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
 }
\ No newline at end of file
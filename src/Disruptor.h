@@ -0,0 +1,521 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Definitions.h"
+#include "os/Futex.h"
+
+namespace conq {
+    /**
+     * Progress counter of a producer or consumer stage: the highest sequence it has
+     * finished with. Alone on its cache line, since other stages poll it.
+     */
+    class alignas (CACHE_LINE_SIZE) Sequence final {
+    public:
+        static constexpr std::int64_t INITIAL = -1;
+
+        explicit Sequence(std::int64_t initial = INITIAL) noexcept :
+                m_value(initial) {}
+
+        Sequence(const Sequence&) = delete;
+        Sequence& operator=(const Sequence&) = delete;
+
+    public:
+        [[nodiscard]]
+        std::int64_t get() const noexcept {
+            return m_value.load(std::memory_order_acquire);
+        }
+
+        void set(std::int64_t value) noexcept {
+            m_value.store(value, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<std::int64_t> m_value;
+    };
+
+    /**
+     * Lowest of 'sequences', or 'fallback' if there are none.
+     */
+    inline std::int64_t minimum(const std::vector<const Sequence*>& sequences, std::int64_t fallback) noexcept {
+        for (const auto sequence: sequences) {
+            fallback = std::min(fallback, sequence->get());
+        }
+        return fallback;
+    }
+
+    /**
+     * Wait strategy: how a stage waits for its inputs and a producer for free slots.
+     * wait(ready) returns once ready() holds; signal() follows every publish and every
+     * batch a stage completes. This one has the lowest latency and burns a core per
+     * waiting thread.
+     */
+    struct BusySpinWait final {
+        template<typename Ready>
+        void wait(Ready&& ready) noexcept(noexcept(ready())) {
+            while (!ready()) {
+                cpu_relax();
+            }
+        }
+
+        void signal() noexcept {}
+    };
+
+    /** Spins briefly, then yields; for as many busy threads as cores. */
+    struct YieldingWait final {
+        template<typename Ready>
+        void wait(Ready&& ready) noexcept(noexcept(ready())) {
+            for (int i = 0; !ready(); ++i) {
+                if (i < SPINS) {
+                    cpu_relax();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        void signal() noexcept {}
+
+        static constexpr int SPINS = 100;
+    };
+
+    /**
+     * Spins briefly, then sleeps on a futex; signal() costs a syscall only while
+     * something sleeps. For stages that idle for long stretches.
+     */
+    class BlockingWait final {
+    public:
+        template<typename Ready>
+        void wait(Ready&& ready) {
+            for (int i = 0; i < futex::SPINS; ++i) {
+                if (ready()) {
+                    return;
+                }
+                cpu_relax();
+            }
+
+            while (true) {
+                const auto epoch = m_epoch.load(std::memory_order_acquire);
+                m_sleepers.fetch_add(1, std::memory_order_relaxed);
+                // Pairs with the fence in signal(): either ready() sees the progress or
+                // signal() sees the sleeper.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (ready()) {
+                    m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
+                (void) futex::wait(m_epoch, epoch);
+                m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        void signal() noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_sleepers.load(std::memory_order_relaxed) != 0) {
+                m_epoch.fetch_add(1, std::memory_order_release);
+                futex::wake(m_epoch, std::numeric_limits<int>::max());
+            }
+        }
+
+    private:
+        alignas (CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_epoch{};
+        std::atomic<std::uint32_t> m_sleepers{};
+    };
+
+    /**
+     * Claims and publishes sequences for one producer thread; claiming is plain
+     * arithmetic on producer-local state.
+     */
+    template<std::size_t LEN, typename Wait>
+    class SingleProducerSequencer final {
+    public:
+        explicit SingleProducerSequencer(Wait& wait) noexcept :
+                m_wait(&wait) {}
+
+    public:
+        /**
+         * Claims the next 'n' sequences and returns the highest, waiting while that
+         * would overrun the slowest gating stage.
+         */
+        std::int64_t next(std::int64_t n = 1) {
+            const auto high = m_next + n;
+            const auto wrap = high - static_cast<std::int64_t>(LEN);
+            if (wrap > m_gating_cache) {
+                m_wait->wait([&]() {
+                    m_gating_cache = minimum(m_gating, m_next);
+                    return wrap <= m_gating_cache;
+                });
+            }
+            m_next = high;
+            return high;
+        }
+
+        std::optional<std::int64_t> try_next(std::int64_t n = 1) {
+            const auto high = m_next + n;
+            if (high - static_cast<std::int64_t>(LEN) > m_gating_cache) {
+                m_gating_cache = minimum(m_gating, m_next);
+                if (high - static_cast<std::int64_t>(LEN) > m_gating_cache) {
+                    return std::nullopt;
+                }
+            }
+            m_next = high;
+            return high;
+        }
+
+        void publish(std::int64_t, std::int64_t high) noexcept {
+            m_cursor.set(high);
+            m_wait->signal();
+        }
+
+        /**
+         * Highest sequence claimed; for a single producer also the highest published.
+         */
+        [[nodiscard]]
+        std::int64_t cursor() const noexcept {
+            return m_cursor.get();
+        }
+
+        /**
+         * Highest sequence from 'low' up to 'available' that consumers may read.
+         */
+        [[nodiscard]]
+        std::int64_t highest_published(std::int64_t, std::int64_t available) const noexcept {
+            return available;
+        }
+
+        void add_gating(const Sequence& sequence) {
+            m_gating.push_back(&sequence);
+        }
+
+    private:
+        Wait* m_wait;
+        Sequence m_cursor{};
+        std::int64_t m_next{Sequence::INITIAL};
+        std::int64_t m_gating_cache{Sequence::INITIAL};
+        std::vector<const Sequence*> m_gating{};
+    };
+
+    /**
+     * Claims sequences for any number of producer threads with one fetch_add. Slots
+     * are published individually, out of order, by recording the lap of the sequence
+     * that filled them; consumers read up to the first gap.
+     */
+    template<std::size_t LEN, typename Wait>
+    class MultiProducerSequencer final {
+    public:
+        explicit MultiProducerSequencer(Wait& wait) noexcept :
+                m_wait(&wait) {
+            for (auto& lap: m_published) {
+                lap.store(-1, std::memory_order_relaxed);
+            }
+        }
+
+    public:
+        std::int64_t next(std::int64_t n = 1) {
+            const auto high = m_claimed.fetch_add(n, std::memory_order_acq_rel) + n;
+            const auto wrap = high - static_cast<std::int64_t>(LEN);
+            if (wrap > m_gating_cache.load(std::memory_order_relaxed)) {
+                m_wait->wait([&]() {
+                    const auto gating = minimum(m_gating, high);
+                    m_gating_cache.store(gating, std::memory_order_relaxed);
+                    return wrap <= gating;
+                });
+            }
+            return high;
+        }
+
+        std::optional<std::int64_t> try_next(std::int64_t n = 1) {
+            auto current = m_claimed.load(std::memory_order_acquire);
+            while (true) {
+                const auto high = current + n;
+                const auto gating = minimum(m_gating, current);
+                m_gating_cache.store(gating, std::memory_order_relaxed);
+                if (high - static_cast<std::int64_t>(LEN) > gating) {
+                    return std::nullopt;
+                }
+                if (m_claimed.compare_exchange_weak(current, high, std::memory_order_acq_rel)) {
+                    return high;
+                }
+            }
+        }
+
+        void publish(std::int64_t low, std::int64_t high) noexcept {
+            for (auto sequence = low; sequence <= high; ++sequence) {
+                m_published[index(sequence)].store(lap(sequence), std::memory_order_release);
+            }
+            m_wait->signal();
+        }
+
+        [[nodiscard]]
+        std::int64_t cursor() const noexcept {
+            return m_claimed.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]]
+        std::int64_t highest_published(std::int64_t low, std::int64_t available) const noexcept {
+            for (auto sequence = low; sequence <= available; ++sequence) {
+                if (m_published[index(sequence)].load(std::memory_order_acquire) != lap(sequence)) {
+                    return sequence - 1;
+                }
+            }
+            return available;
+        }
+
+        void add_gating(const Sequence& sequence) {
+            m_gating.push_back(&sequence);
+        }
+
+    private:
+        static std::size_t index(std::int64_t sequence) noexcept {
+            return ring_buffer_index<LEN>(static_cast<std::size_t>(sequence));
+        }
+
+        static std::int64_t lap(std::int64_t sequence) noexcept {
+            return sequence >> std::countr_zero(LEN);
+        }
+
+        Wait* m_wait;
+        alignas (CACHE_LINE_SIZE) std::atomic<std::int64_t> m_claimed{Sequence::INITIAL};
+        alignas (CACHE_LINE_SIZE) std::atomic<std::int64_t> m_gating_cache{Sequence::INITIAL};
+        std::vector<const Sequence*> m_gating{};
+        std::array<std::atomic<std::int64_t>, LEN> m_published;
+    };
+
+    enum class Producers {
+        Single,
+        Multi,
+    };
+
+    /**
+     * Disruptor ring: LEN preallocated events that producers fill in place and that
+     * consumer stages then read and update in place, each stage gated on the
+     * sequences of the stages before it. An event is written once and travels the
+     * whole pipeline without being copied.
+     *
+     * Set up the graph before any thread starts: every stage's barrier lists its
+     * upstream sequences, and the ring is gated on the last stages with add_gating(),
+     * so producers never overwrite an event still in use. It is large (LEN events
+     * inline), so allocate it on the heap.
+     */
+    template<QElement T, std::size_t LEN, Producers PRODUCERS = Producers::Single, typename Wait = YieldingWait>
+    requires PowerOfTwo<LEN>
+    class RingBuffer final {
+    public:
+        using Event = T;
+        using Sequencer = std::conditional_t<PRODUCERS == Producers::Single,
+                SingleProducerSequencer<LEN, Wait>, MultiProducerSequencer<LEN, Wait>>;
+
+        RingBuffer() = default;
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+    public:
+        /**
+         * Claims 'n' consecutive sequences, waiting for room; returns the highest.
+         */
+        std::int64_t next(std::int64_t n = 1) {
+            return m_sequencer.next(n);
+        }
+
+        std::optional<std::int64_t> try_next(std::int64_t n = 1) {
+            return m_sequencer.try_next(n);
+        }
+
+        T& operator[](std::int64_t sequence) noexcept {
+            return m_events[ring_buffer_index<LEN>(static_cast<std::size_t>(sequence))];
+        }
+
+        const T& operator[](std::int64_t sequence) const noexcept {
+            return m_events[ring_buffer_index<LEN>(static_cast<std::size_t>(sequence))];
+        }
+
+        void publish(std::int64_t sequence) noexcept {
+            m_sequencer.publish(sequence, sequence);
+        }
+
+        void publish(std::int64_t low, std::int64_t high) noexcept {
+            m_sequencer.publish(low, high);
+        }
+
+        /**
+         * Claims one event, lets fill(event, sequence) write it in place, publishes it.
+         */
+        template<typename F>
+        std::int64_t publish_event(F&& fill) {
+            const auto sequence = next();
+            std::forward<F>(fill)((*this)[sequence], sequence);
+            publish(sequence);
+            return sequence;
+        }
+
+        /**
+         * Producers will not pass 'sequence' by more than LEN. Call before producing.
+         */
+        void add_gating(const Sequence& sequence) {
+            m_sequencer.add_gating(sequence);
+        }
+
+        [[nodiscard]]
+        std::int64_t cursor() const noexcept {
+            return m_sequencer.cursor();
+        }
+
+        [[nodiscard]]
+        const Sequencer& sequencer() const noexcept {
+            return m_sequencer;
+        }
+
+        [[nodiscard]]
+        Wait& wait_strategy() noexcept {
+            return m_wait;
+        }
+
+        static constexpr std::size_t capacity() noexcept {
+            return LEN;
+        }
+
+    private:
+        Wait m_wait{};
+        Sequencer m_sequencer{m_wait};
+        alignas (CACHE_LINE_SIZE) std::array<T, LEN> m_events{};
+    };
+
+    /**
+     * What a consumer stage waits on: the ring's published sequences and the
+     * sequences of its upstream stages.
+     */
+    template<typename Ring>
+    class SequenceBarrier final {
+    public:
+        SequenceBarrier(Ring& ring, std::vector<const Sequence*> dependencies) :
+                m_ring(&ring),
+                m_dependencies(std::move(dependencies)) {}
+
+        SequenceBarrier(const SequenceBarrier&) = delete;
+        SequenceBarrier& operator=(const SequenceBarrier&) = delete;
+
+    public:
+        /**
+         * Waits until 'sequence' is available and returns the highest available
+         * sequence, which may be well past it (the batch); nullopt once alerted.
+         */
+        std::optional<std::int64_t> wait_for(std::int64_t sequence) {
+            std::int64_t available{};
+            m_ring->wait_strategy().wait([&]() {
+                if (m_alerted.load(std::memory_order_acquire)) {
+                    return true;
+                }
+                const auto upstream = minimum(m_dependencies, m_ring->cursor());
+                available = m_ring->sequencer().highest_published(sequence, upstream);
+                return available >= sequence;
+            });
+
+            if (m_alerted.load(std::memory_order_acquire)) {
+                return std::nullopt;
+            }
+            return available;
+        }
+
+        /**
+         * Makes current and future wait_for() calls return nullopt.
+         */
+        void alert() noexcept {
+            m_alerted.store(true, std::memory_order_release);
+            m_ring->wait_strategy().signal();
+        }
+
+        void clear_alert() noexcept {
+            m_alerted.store(false, std::memory_order_release);
+        }
+
+        [[nodiscard]]
+        bool alerted() const noexcept {
+            return m_alerted.load(std::memory_order_acquire);
+        }
+
+    private:
+        Ring* m_ring;
+        std::vector<const Sequence*> m_dependencies;
+        std::atomic<bool> m_alerted{};
+    };
+
+    /**
+     * Consumer stage: handler(event, sequence, end_of_batch) is called for every event
+     * in order, on the thread that calls run(), with the event writable in place for
+     * the stages downstream. The stage's sequence advances once per batch, so a stage
+     * that falls behind catches up in large batches at the cost of one store each.
+     */
+    template<typename Ring, typename Handler>
+    requires std::invocable<Handler&, typename Ring::Event&, std::int64_t, bool>
+    class BatchProcessor final {
+    public:
+        BatchProcessor(Ring& ring, std::vector<const Sequence*> dependencies, Handler handler) :
+                m_ring(&ring),
+                m_barrier(ring, std::move(dependencies)),
+                m_handler(std::move(handler)) {}
+
+        BatchProcessor(const BatchProcessor&) = delete;
+        BatchProcessor& operator=(const BatchProcessor&) = delete;
+
+    public:
+        /**
+         * Handles events until halt(); returns how many it handled.
+         */
+        std::uint64_t run() {
+            std::uint64_t handled = 0;
+            auto next = m_sequence.get() + 1;
+            while (true) {
+                const auto available = m_barrier.wait_for(next);
+                if (!available.has_value()) {
+                    return handled;
+                }
+
+                for (auto sequence = next; sequence <= available.value(); ++sequence) {
+                    m_handler((*m_ring)[sequence], sequence, sequence == available.value());
+                }
+                handled += static_cast<std::uint64_t>(available.value() - next + 1);
+                m_sequence.set(available.value());
+                m_ring->wait_strategy().signal();
+                next = available.value() + 1;
+            }
+        }
+
+        /**
+         * Stops run() at its next wait; events not yet handled stay unhandled.
+         */
+        void halt() noexcept {
+            m_barrier.alert();
+        }
+
+        /**
+         * Gate downstream stages, or the ring, on this.
+         */
+        [[nodiscard]]
+        const Sequence& sequence() const noexcept {
+            return m_sequence;
+        }
+
+        [[nodiscard]]
+        Handler& handler() noexcept {
+            return m_handler;
+        }
+
+    private:
+        Ring* m_ring;
+        SequenceBarrier<Ring> m_barrier;
+        Sequence m_sequence{};
+        Handler m_handler;
+    };
+}
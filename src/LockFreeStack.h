@@ -4,10 +4,11 @@
 #include <atomic>
 #include <memory>
 #include "Definitions.h"
+#include "QueueStats.h"
 
 
 namespace conq {
-    template<typename T>
+    template<typename T, typename Stats = NoStats>
     class LockFreeStack {
     public:
         LockFreeStack() = default;
@@ -17,22 +18,36 @@ namespace conq {
         void push(U&& value) {
             auto new_node = std::make_shared<Node>(std::forward<U>(value));
             auto origin = head.load(std::memory_order_relaxed);
-            do {
+            new_node->next = origin;
+            while (!head.compare_exchange_weak(origin, new_node, std::memory_order_release, std::memory_order_relaxed)) {
+                m_stats.on(QueueEvent::CasRetry);
                 new_node->next = origin;
-            } while (!head.compare_exchange_weak(origin, new_node, std::memory_order_release, std::memory_order_relaxed));
+            }
+            m_stats.on(QueueEvent::Push);
         }
 
         std::optional<T> pop() {
             auto old_head = head.load(std::memory_order_acquire);
-            do {
+            while (true) {
                 if (!old_head) {
+                    m_stats.on(QueueEvent::Empty);
                     return std::nullopt;
                 }
 
-            } while (!head.compare_exchange_weak(old_head, old_head->next, std::memory_order_release, std::memory_order_relaxed));
+                if (head.compare_exchange_weak(old_head, old_head->next, std::memory_order_release, std::memory_order_relaxed)) {
+                    break;
+                }
+                m_stats.on(QueueEvent::CasRetry);
+            }
+            m_stats.on(QueueEvent::Pop);
             return old_head->value;
         }
 
+        [[nodiscard]]
+        const Stats& stats() const noexcept {
+            return m_stats;
+        }
+
     private:
         struct alignas (CACHE_LINE_SIZE) Node {
             explicit Node(T value) : value(std::move(value)) {}
@@ -42,5 +57,6 @@ namespace conq {
         };
 
         std::atomic<std::shared_ptr<Node>> head{nullptr};
+        [[no_unique_address]] Stats m_stats{};
     };
 }
\ No newline at end of file
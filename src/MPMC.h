@@ -1,15 +1,18 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <atomic>
 #include <array>
+#include <bit>
 #include <thread>
 
 #include "Definitions.h"
+#include "QueueStats.h"
 
 namespace conq {
-    template<QElement T, std::size_t LEN>
+    template<QElement T, std::size_t LEN, typename Stats = NoStats>
     requires PowerOfTwo<LEN>
     class MPMCBoundedQueue final {
     public:
@@ -22,6 +25,7 @@ namespace conq {
             auto new_value = head + 1;
             for (;;) {
                 if (head - m_tail.load(std::memory_order_acquire) == LEN) {
+                    m_stats.on(QueueEvent::Full);
                     return false;
                 }
 
@@ -29,17 +33,25 @@ namespace conq {
                     break;
                 }
 
+                m_stats.on(QueueEvent::CasRetry);
                 std::this_thread::yield();
                 new_value = head + 1;
             }
 
             auto& slot = m_buffer[ring_buffer_index<LEN>(new_value - 1)];
             while (slot.tag.test(std::memory_order_acquire)) {
+                m_stats.on(QueueEvent::Spin);
                 std::this_thread::yield();
             }
 
             slot.value = std::forward<U>(value);
             slot.tag.test_and_set(std::memory_order_release);
+            m_stats.on(QueueEvent::Push);
+            if constexpr (Stats::ENABLED) {
+                // Consumers may already have popped this element and those after it.
+                const auto tail = m_tail.load(std::memory_order_relaxed);
+                m_stats.depth(tail > new_value ? 0 : new_value - tail);
+            }
             return true;
         }
 
@@ -48,6 +60,7 @@ namespace conq {
             auto new_value = tail + 1;
             for (;;) {
                 if (tail == m_head.load(std::memory_order_acquire)) {
+                    m_stats.on(QueueEvent::Empty);
                     return std::nullopt;
                 }
 
@@ -55,20 +68,36 @@ namespace conq {
                     break;
                 }
 
+                m_stats.on(QueueEvent::CasRetry);
                 std::this_thread::yield();
                 new_value = tail + 1;
             }
 
             auto& slot = m_buffer[ring_buffer_index<LEN>(new_value - 1)];
             while (!slot.tag.test(std::memory_order_acquire)) {
+                m_stats.on(QueueEvent::Spin);
                 std::this_thread::yield();
             }
 
             auto value = std::move(slot.value);
             slot.tag.clear(std::memory_order_release);
+            m_stats.on(QueueEvent::Pop);
             return value;
         }
 
+        /**
+         * Snapshot; another thread may change it right after.
+         */
+        [[nodiscard]]
+        bool empty() const noexcept {
+            return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]]
+        const Stats& stats() const noexcept {
+            return m_stats;
+        }
+
     private:
         struct alignas (CACHE_LINE_SIZE) Slot {
             T value{};
@@ -78,6 +107,96 @@ namespace conq {
         alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_head = 0;
         alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail = 0;
         std::array<Slot, LEN> m_buffer;
+        [[no_unique_address]] Stats m_stats{};
     };
-}
 
+    /**
+     * Bounded MPMC queue with LEVELS priority classes, 0 being the highest. Each level
+     * is an MPMCBoundedQueue of LEN elements; a bitmap of the non-empty levels lets a
+     * consumer find the highest one with a single load (and an empty queue costs just
+     * that load), instead of polling one queue per priority. Within a level elements
+     * stay FIFO; lower levels wait while higher ones have work.
+     */
+    template<QElement T, std::size_t LEN, std::size_t LEVELS, typename Stats = NoStats>
+    requires PowerOfTwo<LEN> && (LEVELS > 0 && LEVELS <= 64)
+    class PriorityMPMCQueue final {
+    public:
+        PriorityMPMCQueue() = default;
+
+        /**
+         * Fails if 'priority' is out of range or its level is full.
+         */
+        template<typename U>
+        requires std::convertible_to<U, T>
+        bool try_push(std::size_t priority, U &&value) {
+            if (priority >= LEVELS || !m_levels[priority].try_push(std::forward<U>(value))) {
+                return false;
+            }
+
+            m_nonempty.fetch_or(bit(priority), std::memory_order_acq_rel);
+            return true;
+        }
+
+        /**
+         * Pops from the highest-priority non-empty level.
+         */
+        std::optional<T> try_pop() {
+            std::size_t priority{};
+            return try_pop(priority);
+        }
+
+        /**
+         * As try_pop(), and reports the level the element came from.
+         */
+        std::optional<T> try_pop(std::size_t& priority) {
+            auto nonempty = m_nonempty.load(std::memory_order_acquire);
+            while (nonempty != 0) {
+                priority = static_cast<std::size_t>(std::countr_zero(nonempty));
+                auto& level = m_levels[priority];
+                if (auto value = level.try_pop(); value.has_value()) {
+                    return value;
+                }
+
+                // Looked empty: clear its bit, then look again, since a producer may
+                // have pushed after the pop and set the bit before the clear.
+                m_nonempty.fetch_and(~bit(priority), std::memory_order_acq_rel);
+                if (!level.empty()) {
+                    m_nonempty.fetch_or(bit(priority), std::memory_order_acq_rel);
+                }
+                nonempty = m_nonempty.load(std::memory_order_acquire);
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * Snapshot; another thread may change it right after. A set bit can outlive its
+         * level's last element until the next pop, so those levels are checked.
+         */
+        [[nodiscard]]
+        bool empty() const noexcept {
+            for (auto nonempty = m_nonempty.load(std::memory_order_acquire); nonempty != 0; nonempty &= nonempty - 1) {
+                if (!m_levels[static_cast<std::size_t>(std::countr_zero(nonempty))].empty()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]]
+        const Stats& stats(std::size_t priority) const noexcept {
+            return m_levels[priority].stats();
+        }
+
+        static constexpr std::size_t levels() noexcept {
+            return LEVELS;
+        }
+
+    private:
+        static constexpr std::uint64_t bit(std::size_t priority) noexcept {
+            return std::uint64_t{1} << priority;
+        }
+
+        alignas (CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_nonempty{};
+        std::array<MPMCBoundedQueue<T, LEN, Stats>, LEVELS> m_levels;
+    };
+}
@@ -5,9 +5,10 @@
 #include <atomic>
 #include <array>
 #include "Definitions.h"
+#include "QueueStats.h"
 
 namespace conq {
-    template<QElement T, std::size_t LEN>
+    template<QElement T, std::size_t LEN, typename Stats = NoStats>
     requires PowerOfTwo<LEN>
     class MPSCBoundedQueue final {
     public:
@@ -20,6 +21,7 @@ namespace conq {
             auto new_value = head + 1;
             for (;;) {
                 if (head - m_tail.load(std::memory_order_acquire) == LEN) {
+                    m_stats.on(QueueEvent::Full);
                     return false;
                 }
 
@@ -27,6 +29,7 @@ namespace conq {
                     break;
                 }
 
+                m_stats.on(QueueEvent::CasRetry);
                 std::this_thread::yield();
                 new_value = head + 1;
             }
@@ -34,6 +37,12 @@ namespace conq {
             auto& slot = m_buffer[ring_buffer_index<LEN>(new_value - 1)];
             slot.value = std::forward<U>(value);
             slot.tag.test_and_set(std::memory_order_release);
+            m_stats.on(QueueEvent::Push);
+            if constexpr (Stats::ENABLED) {
+                // Consumers may already have popped this element and those after it.
+                const auto tail = m_tail.load(std::memory_order_relaxed);
+                m_stats.depth(tail > new_value ? 0 : new_value - tail);
+            }
             return true;
         }
 
@@ -41,11 +50,14 @@ namespace conq {
             const auto tail = m_tail.load(std::memory_order_acquire);
             const auto head = m_head.load(std::memory_order_acquire);
             if (head == tail) {
+                m_stats.on(QueueEvent::Empty);
                 return std::nullopt;
             }
 
             auto& slot = m_buffer[ring_buffer_index<LEN>(tail)];
             if (!slot.tag.test(std::memory_order_acquire)) {
+                // Claimed by a producer that has not published yet: nothing to pop.
+                m_stats.on(QueueEvent::Empty);
                 return std::nullopt;
             }
 
@@ -54,9 +66,15 @@ namespace conq {
             slot.tag.notify_one();
 
             m_tail.store(tail + 1, std::memory_order_release);
+            m_stats.on(QueueEvent::Pop);
             return value;
         }
 
+        [[nodiscard]]
+        const Stats& stats() const noexcept {
+            return m_stats;
+        }
+
     private:
         struct alignas (CACHE_LINE_SIZE) Slot {
             T value{};
@@ -66,5 +84,6 @@ namespace conq {
         alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_head = 0;
         alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail = 0;
         std::array<Slot, LEN> m_buffer;
+        [[no_unique_address]] Stats m_stats{};
     };
 }
\ No newline at end of file
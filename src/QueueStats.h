@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "Definitions.h"
+
+namespace conq {
+    enum class QueueEvent {
+        Push,
+        Pop,
+        Full,
+        /** A pop that returned nothing, including when the next element is not published yet. */
+        Empty,
+        CasRetry,
+        /** One wait, inside a push or pop, for a slot another thread has claimed. */
+        Spin,
+    };
+
+    inline constexpr std::size_t QUEUE_EVENT_COUNT = 6;
+
+    /**
+     * Statistics policy of the queues, chosen at compile time. NoStats is the default:
+     * its hooks are empty and the member is [[no_unique_address]], so a queue without
+     * statistics has the same layout and code as before.
+     */
+    struct NoStats final {
+        static constexpr bool ENABLED = false;
+
+        void on(QueueEvent, std::uint64_t = 1) noexcept {}
+
+        void depth(std::size_t) noexcept {}
+    };
+
+    struct QueueStatsSnapshot final {
+        std::uint64_t push{};
+        std::uint64_t pop{};
+        std::uint64_t full{};
+        std::uint64_t empty{};
+        std::uint64_t cas_retries{};
+        std::uint64_t spins{};
+        std::size_t high_water{};
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const QueueStatsSnapshot& obj) {
+        os << "Push: " << obj.push
+           << " Pop: " << obj.pop
+           << " Full: " << obj.full
+           << " Empty: " << obj.empty
+           << " CAS retries: " << obj.cas_retries
+           << " Spins: " << obj.spins
+           << " High water: " << obj.high_water;
+        return os;
+    }
+
+    /**
+     * Counting statistics policy. Each thread updates its own cache-line shard (threads
+     * are assigned round-robin, so more than SHARDS threads share lines but stay
+     * correct), which keeps the cost to an uncontended relaxed add. Holds no pointers,
+     * so queues in shared memory carry their statistics with them.
+     *
+     * The high-water mark is tracked by the bounded queues, which know their depth.
+     */
+    template<std::size_t SHARDS = 16>
+    class QueueStats final {
+    public:
+        static constexpr bool ENABLED = true;
+
+        QueueStats() = default;
+
+        QueueStats(const QueueStats&) = delete;
+        QueueStats& operator=(const QueueStats&) = delete;
+
+    public:
+        void on(QueueEvent event, std::uint64_t n = 1) noexcept {
+            m_shards[shard_index()].counters[static_cast<std::size_t>(event)].fetch_add(n, std::memory_order_relaxed);
+        }
+
+        void depth(std::size_t depth) noexcept {
+            auto high = m_high_water.load(std::memory_order_relaxed);
+            while (depth > high && !m_high_water.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {}
+        }
+
+        [[nodiscard]]
+        std::uint64_t get(QueueEvent event) const noexcept {
+            std::uint64_t total{};
+            for (const auto& shard: m_shards) {
+                total += shard.counters[static_cast<std::size_t>(event)].load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        [[nodiscard]]
+        QueueStatsSnapshot snapshot() const noexcept {
+            return {
+                    get(QueueEvent::Push),
+                    get(QueueEvent::Pop),
+                    get(QueueEvent::Full),
+                    get(QueueEvent::Empty),
+                    get(QueueEvent::CasRetry),
+                    get(QueueEvent::Spin),
+                    m_high_water.load(std::memory_order_relaxed),
+            };
+        }
+
+        void reset() noexcept {
+            for (auto& shard: m_shards) {
+                for (auto& counter: shard.counters) {
+                    counter.store(0, std::memory_order_relaxed);
+                }
+            }
+            m_high_water.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        static std::size_t shard_index() noexcept {
+            static std::atomic<std::size_t> next{};
+            static thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+            return index;
+        }
+
+        struct alignas (CACHE_LINE_SIZE) Shard {
+            std::array<std::atomic<std::uint64_t>, QUEUE_EVENT_COUNT> counters{};
+        };
+
+        std::array<Shard, SHARDS> m_shards{};
+        alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_high_water{};
+    };
+}
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Definitions.h"
+
+namespace conq {
+    /**
+     * Quiescent-state-based RCU for threads of one process. Read-side sections cost
+     * nothing: no stores, fences or read-modify-writes. In exchange every reader thread
+     * registers and calls quiescent() at points where it holds no RCU-protected
+     * pointer (once per event-loop iteration, for example), and goes offline() before
+     * blocking. A grace period ends when every online reader has passed such a point;
+     * a reader that never does stalls synchronize() and reclamation.
+     */
+    template<std::size_t MAX_READERS = 128>
+    class RcuDomain final {
+    private:
+        struct alignas (CACHE_LINE_SIZE) Slot {
+            std::atomic<bool> used{};
+            /** Epoch seen at the last quiescent point; OFFLINE while not reading. */
+            std::atomic<std::uint64_t> seen{};
+        };
+
+        static constexpr std::uint64_t OFFLINE = 0;
+
+    public:
+        /**
+         * One registered reader thread. Keep it on that thread; the destructor
+         * unregisters it.
+         */
+        class Reader final {
+        public:
+            Reader(Reader&& other) noexcept :
+                    m_domain(std::exchange(other.m_domain, nullptr)),
+                    m_slot(other.m_slot) {}
+
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+
+            ~Reader() {
+                if (m_domain != nullptr) {
+                    offline();
+                    m_domain->m_slots[m_slot].used.store(false, std::memory_order_release);
+                }
+            }
+
+        public:
+            /**
+             * Marks a read-side section. It compiles to nothing in release builds; in
+             * debug builds quiescent() inside one asserts.
+             */
+            class Guard final {
+            public:
+                explicit Guard(const Reader& reader) noexcept :
+                        m_reader(&reader) {
+                    assert(m_reader->online_now() && "read section on an offline reader");
+#ifndef NDEBUG
+                    ++m_reader->m_depth;
+#endif
+                }
+
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+
+                ~Guard() {
+#ifndef NDEBUG
+                    --m_reader->m_depth;
+#endif
+                }
+
+            private:
+                const Reader* m_reader;
+            };
+
+            [[nodiscard]]
+            Guard read() const noexcept {
+                return Guard(*this);
+            }
+
+            /**
+             * Announces that this thread holds no protected pointer.
+             */
+            void quiescent() noexcept {
+                assert(m_depth == 0 && "quiescent() inside a read section");
+                const auto epoch = m_domain->m_epoch.load(std::memory_order_acquire);
+                m_domain->m_slots[m_slot].seen.store(epoch, std::memory_order_release);
+            }
+
+            /**
+             * Leaves the reader set, e.g. before blocking, so grace periods do not wait
+             * for this thread.
+             */
+            void offline() noexcept {
+                assert(m_depth == 0 && "offline() inside a read section");
+                m_domain->m_slots[m_slot].seen.store(OFFLINE, std::memory_order_release);
+            }
+
+            void online() noexcept {
+                const auto epoch = m_domain->m_epoch.load(std::memory_order_acquire);
+                m_domain->m_slots[m_slot].seen.store(epoch, std::memory_order_relaxed);
+                // Pairs with the fence in synchronize(): either it sees this thread
+                // online or this thread sees every pointer unpublished before it.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+
+        private:
+            friend class RcuDomain;
+
+            Reader(RcuDomain* domain, std::size_t slot) noexcept :
+                    m_domain(domain),
+                    m_slot(slot) {}
+
+            [[nodiscard]]
+            bool online_now() const noexcept {
+                return m_domain->m_slots[m_slot].seen.load(std::memory_order_relaxed) != OFFLINE;
+            }
+
+            RcuDomain* m_domain;
+            std::size_t m_slot;
+#ifndef NDEBUG
+            mutable int m_depth{};
+#endif
+        };
+
+    public:
+        RcuDomain() = default;
+
+        RcuDomain(const RcuDomain&) = delete;
+        RcuDomain& operator=(const RcuDomain&) = delete;
+
+        /**
+         * Runs the callbacks still pending; no reader may be inside a read section.
+         */
+        ~RcuDomain() {
+            for (auto& pending: m_pending) {
+                pending.callback();
+            }
+        }
+
+    public:
+        /**
+         * Registers the calling thread as an online reader; nullopt when all
+         * MAX_READERS slots are taken.
+         */
+        [[nodiscard]]
+        std::optional<Reader> register_reader() {
+            for (std::size_t i = 0; i < MAX_READERS; ++i) {
+                bool used = false;
+                if (m_slots[i].used.compare_exchange_strong(used, true, std::memory_order_acquire)) {
+                    Reader reader(this, i);
+                    reader.online();
+                    return reader;
+                }
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * Waits until every reader online now has passed a quiescent point, so nothing
+         * unpublished before the call is still referenced. The caller must not be
+         * inside a read section; if it is a reader, it must be offline.
+         */
+        void synchronize() {
+            const auto target = advance();
+            for (auto& slot: m_slots) {
+                wait_for(slot, target);
+            }
+        }
+
+        /**
+         * Runs 'callback' once a grace period has passed, from a later reclaim(),
+         * barrier() or the destructor. Does not block.
+         */
+        void call_rcu(std::function<void()> callback) {
+            std::lock_guard lock(m_pending_mutex);
+            m_pending.push_back(Pending{advance(), std::move(callback)});
+        }
+
+        /**
+         * Runs the call_rcu() callbacks whose grace period has ended. Returns how many ran.
+         */
+        std::size_t reclaim() {
+            const auto completed = completed_epoch();
+            std::vector<Pending> ready;
+            {
+                std::lock_guard lock(m_pending_mutex);
+                std::size_t done = 0;
+                while (done < m_pending.size() && m_pending[done].target <= completed) {
+                    ++done;
+                }
+                ready.assign(std::make_move_iterator(m_pending.begin()), std::make_move_iterator(m_pending.begin() + done));
+                m_pending.erase(m_pending.begin(), m_pending.begin() + done);
+            }
+
+            for (auto& pending: ready) {
+                pending.callback();
+            }
+            return ready.size();
+        }
+
+        /**
+         * Waits for a grace period and runs every callback queued before the call.
+         */
+        void barrier() {
+            synchronize();
+            (void) reclaim();
+        }
+
+        [[nodiscard]]
+        std::size_t pending() const {
+            std::lock_guard lock(m_pending_mutex);
+            return m_pending.size();
+        }
+
+    private:
+        struct Pending {
+            std::uint64_t target{};
+            std::function<void()> callback;
+        };
+
+        std::uint64_t advance() noexcept {
+            const auto target = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return target;
+        }
+
+        static bool passed(const Slot& slot, std::uint64_t target) noexcept {
+            const auto seen = slot.seen.load(std::memory_order_acquire);
+            return seen == OFFLINE || seen >= target;
+        }
+
+        static void wait_for(const Slot& slot, std::uint64_t target) noexcept {
+            for (int i = 0; i < SPINS && !passed(slot, target); ++i) {
+                cpu_relax();
+            }
+            while (!passed(slot, target)) {
+                std::this_thread::yield();
+            }
+        }
+
+        std::uint64_t completed_epoch() const noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto completed = m_epoch.load(std::memory_order_acquire);
+            for (const auto& slot: m_slots) {
+                const auto seen = slot.seen.load(std::memory_order_acquire);
+                if (seen != OFFLINE && seen < completed) {
+                    completed = seen;
+                }
+            }
+            return completed;
+        }
+
+        static constexpr int SPINS = 1024;
+
+        alignas (CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_epoch{1};
+        std::array<Slot, MAX_READERS> m_slots{};
+        mutable std::mutex m_pending_mutex;
+        std::vector<Pending> m_pending;
+    };
+
+    /**
+     * Pointer to an immutable T that readers follow inside RCU read sections while a
+     * writer replaces it. load() is a single acquire load (a plain mov on x86).
+     * Writers are serialised by an internal mutex; old values are deleted after a
+     * grace period.
+     */
+    template<typename T, typename Domain = RcuDomain<>>
+    class RcuPtr final {
+    public:
+        explicit RcuPtr(Domain& domain, std::unique_ptr<T> initial = nullptr) :
+                m_domain(&domain),
+                m_ptr(initial.release()) {}
+
+        RcuPtr(const RcuPtr&) = delete;
+        RcuPtr& operator=(const RcuPtr&) = delete;
+
+        /**
+         * Deletes the current value; no reader may still use it.
+         */
+        ~RcuPtr() {
+            delete m_ptr.load(std::memory_order_relaxed);
+        }
+
+    public:
+        /**
+         * Valid until the calling reader's next quiescent point.
+         */
+        [[nodiscard]]
+        const T* load() const noexcept {
+            return m_ptr.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Publishes 'value' and hands the old one to call_rcu(); returns without waiting.
+         */
+        void store(std::unique_ptr<T> value) {
+            std::lock_guard lock(m_writer);
+            retire(m_ptr.exchange(value.release(), std::memory_order_acq_rel));
+        }
+
+        /**
+         * Publishes 'value' and returns the old one once no reader can see it. Blocks for
+         * a grace period.
+         */
+        [[nodiscard]]
+        std::unique_ptr<T> exchange(std::unique_ptr<T> value) {
+            std::unique_ptr<T> old;
+            {
+                std::lock_guard lock(m_writer);
+                old.reset(m_ptr.exchange(value.release(), std::memory_order_acq_rel));
+            }
+            m_domain->synchronize();
+            return old;
+        }
+
+        /**
+         * Copy-on-write: publishes a copy of the current value modified by 'fn'.
+         */
+        template<typename F>
+        void update(F&& fn) {
+            std::lock_guard lock(m_writer);
+            const auto current = m_ptr.load(std::memory_order_relaxed);
+            auto next = current == nullptr ? std::make_unique<T>() : std::make_unique<T>(*current);
+            std::forward<F>(fn)(*next);
+            retire(m_ptr.exchange(next.release(), std::memory_order_acq_rel));
+        }
+
+    private:
+        void retire(T* old) {
+            if (old != nullptr) {
+                m_domain->call_rcu([old]() { delete old; });
+            }
+            (void) m_domain->reclaim();
+        }
+
+        Domain* m_domain;
+        std::atomic<T*> m_ptr;
+        std::mutex m_writer;
+    };
+}
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
+#include <optional>
 #include "Definitions.h"
+#include "QueueStats.h"
 
 namespace conq {
     template<typename T>
@@ -10,13 +13,14 @@ namespace conq {
         T data;
     };
 
-    template<QElement T, typename Allocator = std::allocator<Slot<T>>>
+    template<QElement T, typename Allocator = std::allocator<Slot<T>>, typename Stats = NoStats>
     class SPSCQueue final {
     public:
-        SPSCQueue() {
-            m_head = m_allocator.allocate(1);
+        SPSCQueue(): SPSCQueue(Allocator{}) {}
+
+        explicit SPSCQueue(const Allocator& allocator): m_allocator(allocator) {
+            m_head = make_node();
             m_tail = m_head;
-            m_head->next = nullptr;
         }
 
         ~SPSCQueue() {
@@ -25,23 +29,24 @@ namespace conq {
                 output = pop();
             } while (output.has_value());
 
-            m_allocator.deallocate(m_head, 1);
+            free_node(m_head);
         }
 
         template<typename U>
         requires std::convertible_to<U, T>
         void push(U &&input) {
-            auto *node = m_allocator.allocate(1);
+            auto *node = make_node();
             node->data = std::forward<U>(input);
-            node->next.store(nullptr, std::memory_order_relaxed);
 
             m_head->next.store(node, std::memory_order_release);
             m_head = node;
+            m_stats.on(QueueEvent::Push);
         }
 
         std::optional<T> pop() {
             const auto tail = m_tail->next.load(std::memory_order_acquire);
             if (tail == nullptr) {
+                m_stats.on(QueueEvent::Empty);
                 return std::nullopt;
             }
 
@@ -49,13 +54,34 @@ namespace conq {
             auto* _back = m_tail;
             m_tail = _back->next.load(std::memory_order_acquire);
 
-            m_allocator.deallocate(_back, 1);
+            free_node(_back);
+            m_stats.on(QueueEvent::Pop);
             return output;
         }
 
+        [[nodiscard]]
+        const Stats& stats() const noexcept {
+            return m_stats;
+        }
+
     private:
+        using Traits = std::allocator_traits<Allocator>;
+
+        Slot<T>* make_node() {
+            auto *node = Traits::allocate(m_allocator, 1);
+            Traits::construct(m_allocator, node);
+            node->next.store(nullptr, std::memory_order_relaxed);
+            return node;
+        }
+
+        void free_node(Slot<T>* node) noexcept {
+            Traits::destroy(m_allocator, node);
+            Traits::deallocate(m_allocator, node, 1);
+        }
+
         alignas (CACHE_LINE_SIZE) Slot<T> *m_head{};
         alignas (CACHE_LINE_SIZE) Slot<T> *m_tail{};
         Allocator m_allocator{};
+        [[no_unique_address]] Stats m_stats{};
     };
 }
\ No newline at end of file
@@ -6,9 +6,10 @@
 #include <optional>
 
 #include "Definitions.h"
+#include "QueueStats.h"
 
 namespace conq {
-    template<QElement T, std::size_t LEN>
+    template<QElement T, std::size_t LEN, typename Stats = NoStats>
     requires PowerOfTwo<LEN>
     class SPSCMailBox final {
     public:
@@ -20,11 +21,14 @@ namespace conq {
             const auto tail = m_tail.load(std::memory_order_acquire);
             const auto head = m_head.load(std::memory_order_acquire);
             if (head - tail == LEN) {
+                m_stats.on(QueueEvent::Full);
                 return false;
             }
 
             m_buffer[ring_buffer_index<LEN>(head)] = std::forward<U>(value);
             m_head.store(head + 1, std::memory_order_release);
+            m_stats.on(QueueEvent::Push);
+            m_stats.depth(head + 1 - tail);
             return true;
         }
 
@@ -32,17 +36,39 @@ namespace conq {
             const auto head = m_head.load(std::memory_order_acquire);
             const auto tail = m_tail.load(std::memory_order_acquire);
             if (head == tail) {
+                m_stats.on(QueueEvent::Empty);
                 return std::nullopt;
             }
 
             const auto value = std::move(m_buffer[ring_buffer_index<LEN>(tail)]);
             m_tail.store(tail + 1, std::memory_order_release);
+            m_stats.on(QueueEvent::Pop);
             return value;
         }
 
+        /**
+         * The element try_pop() would return, left in place. Consumer side only.
+         */
+        [[nodiscard]]
+        std::optional<T> front() const {
+            const auto head = m_head.load(std::memory_order_acquire);
+            const auto tail = m_tail.load(std::memory_order_acquire);
+            if (head == tail) {
+                return std::nullopt;
+            }
+
+            return m_buffer[ring_buffer_index<LEN>(tail)];
+        }
+
+        [[nodiscard]]
+        const Stats& stats() const noexcept {
+            return m_stats;
+        }
+
     private:
         alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_head = 0;
         alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail = 0;
         std::array<T, LEN> m_buffer;
+        [[no_unique_address]] Stats m_stats{};
     };
 }
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+#include "Definitions.h"
+
+namespace conq {
+    namespace detail {
+        /**
+         * A trivially copyable T held as relaxed atomic words, so a reader racing the
+         * writer reads stale or mixed words (which the sequence check then discards)
+         * instead of performing a data race.
+         */
+        template<typename T>
+        requires std::is_trivially_copyable_v<T>
+        class AtomicWords final {
+        public:
+            void store(const T& value) noexcept {
+                std::array<std::uint64_t, WORDS> words{};
+                std::memcpy(words.data(), &value, sizeof(T));
+                for (std::size_t i = 0; i < WORDS; ++i) {
+                    m_words[i].store(words[i], std::memory_order_relaxed);
+                }
+            }
+
+            [[nodiscard]]
+            T load() const noexcept {
+                std::array<std::uint64_t, WORDS> words{};
+                for (std::size_t i = 0; i < WORDS; ++i) {
+                    words[i] = m_words[i].load(std::memory_order_relaxed);
+                }
+
+                T value;
+                // Trivially copyable but possibly not trivial, which -Wclass-memaccess flags.
+                std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+                return value;
+            }
+
+        private:
+            static constexpr std::size_t WORDS = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+            std::array<std::atomic<std::uint64_t>, WORDS> m_words{};
+        };
+    }
+
+    template<typename T>
+    struct Versioned final {
+        std::uint64_t version{};
+        T value{};
+    };
+
+    /**
+     * Single-writer, many-reader cell for small, frequently replaced state such as a
+     * top of book or a config block. store() is wait-free; readers retry while a store
+     * overlaps their copy and never write to the cell, so any number of them can
+     * poll it without moving its cache lines out of the writer's cache. Lives in a
+     * ShMem segment as well as in process memory.
+     *
+     * Only one thread may call store().
+     */
+    template<typename T>
+    requires std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>
+    class SeqLock final {
+    public:
+        SeqLock() = default;
+
+        explicit SeqLock(const T& value) {
+            store(value);
+        }
+
+        SeqLock(const SeqLock&) = delete;
+        SeqLock& operator=(const SeqLock&) = delete;
+
+    public:
+        void store(const T& value) noexcept {
+            const auto seq = m_seq.load(std::memory_order_relaxed);
+            m_seq.store(seq + 1, std::memory_order_relaxed);
+            // Keeps the data stores below the odd sequence.
+            std::atomic_thread_fence(std::memory_order_release);
+            m_data.store(value);
+            m_seq.store(seq + 2, std::memory_order_release);
+        }
+
+        /**
+         * One attempt; nullopt if a store was in progress.
+         */
+        [[nodiscard]]
+        std::optional<Versioned<T>> try_load() const noexcept {
+            const auto before = m_seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                return std::nullopt;
+            }
+
+            const auto value = m_data.load();
+            // Keeps the data loads above the second sequence read.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) != before) {
+                return std::nullopt;
+            }
+            return Versioned<T>{before / 2, value};
+        }
+
+        [[nodiscard]]
+        Versioned<T> load() const noexcept {
+            while (true) {
+                if (auto result = try_load(); result.has_value()) {
+                    return result.value();
+                }
+                cpu_relax();
+            }
+        }
+
+        /**
+         * Number of completed stores.
+         */
+        [[nodiscard]]
+        std::uint64_t version() const noexcept {
+            return m_seq.load(std::memory_order_acquire) / 2;
+        }
+
+    private:
+        alignas (CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_seq{};
+        detail::AtomicWords<T> m_data{};
+    };
+
+    /**
+     * Ring of the last LEN versions published by a single writer, each under its own
+     * sequence on its own cache lines. A reader copying one version only conflicts
+     * with the writer once the writer has lapped the ring, so slow readers retry far
+     * less than on a SeqLock, and readers that fall behind can catch up on versions
+     * they missed while those are still in the ring.
+     *
+     * Versions are numbered from 1. Only one thread may call publish().
+     */
+    template<typename T, std::size_t LEN>
+    requires std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T> && PowerOfTwo<LEN>
+    class SeqRing final {
+    public:
+        SeqRing() = default;
+
+        SeqRing(const SeqRing&) = delete;
+        SeqRing& operator=(const SeqRing&) = delete;
+
+    public:
+        /**
+         * Returns the version number given to 'value'.
+         */
+        std::uint64_t publish(const T& value) noexcept {
+            const auto version = m_latest.load(std::memory_order_relaxed) + 1;
+            auto& slot = m_slots[ring_buffer_index<LEN>(version)];
+            slot.seq.store(2 * version - 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.data.store(value);
+            slot.seq.store(2 * version, std::memory_order_release);
+            m_latest.store(version, std::memory_order_release);
+            return version;
+        }
+
+        /**
+         * Copies 'version'; nullopt if it has not been published yet or has already
+         * been overwritten.
+         */
+        [[nodiscard]]
+        std::optional<T> read(std::uint64_t version) const noexcept {
+            if (version == 0) {
+                return std::nullopt;
+            }
+
+            const auto& slot = m_slots[ring_buffer_index<LEN>(version)];
+            if (slot.seq.load(std::memory_order_acquire) != 2 * version) {
+                return std::nullopt;
+            }
+
+            const auto value = slot.data.load();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != 2 * version) {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        /**
+         * Most recent version; nullopt before the first publish().
+         */
+        [[nodiscard]]
+        std::optional<Versioned<T>> latest() const noexcept {
+            while (true) {
+                const auto version = m_latest.load(std::memory_order_acquire);
+                if (version == 0) {
+                    return std::nullopt;
+                }
+                if (auto value = read(version); value.has_value()) {
+                    return Versioned<T>{version, value.value()};
+                }
+                cpu_relax();
+            }
+        }
+
+        [[nodiscard]]
+        std::uint64_t version() const noexcept {
+            return m_latest.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Oldest version still readable.
+         */
+        [[nodiscard]]
+        std::uint64_t oldest() const noexcept {
+            const auto latest = version();
+            return latest < LEN ? 1 : latest - LEN + 2;
+        }
+
+    private:
+        struct alignas (CACHE_LINE_SIZE) Slot {
+            std::atomic<std::uint64_t> seq{};
+            detail::AtomicWords<T> data{};
+        };
+
+        alignas (CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_latest{};
+        std::array<Slot, LEN> m_slots{};
+    };
+}
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "Definitions.h"
+#include "Rcu.h"
+#include "allocation/ShmPool.h"
+
+namespace conq {
+    /**
+     * Lock-free ordered map (Herlihy-Shavit skip list). Lookups and range scans neither
+     * lock nor write; insert and erase are lock-free, an erase first marking the
+     * node's links and any traversal then unlinking it. Nodes come from an embedded
+     * ShmPool of N nodes, so the list never calls the allocator after construction;
+     * an erased node returns to the pool after an RCU grace period.
+     *
+     * Every thread that uses the list must be an online reader of 'domain' and pass
+     * quiescent points regularly. Values are immutable once inserted: store an index
+     * or atomics in V to update a level in place. The list is large (N nodes inline),
+     * so allocate it on the heap.
+     */
+    template<typename K, typename V, std::size_t N, typename Compare = std::less<K>, typename Domain = RcuDomain<>>
+    requires (N > 0 && N < (std::size_t{1} << 31) - 2)
+    class SkipList final {
+    public:
+        static constexpr std::size_t MAX_LEVEL = 16;
+
+    private:
+        /** Pool index of the next node; the top bit marks the owning node as erased. */
+        using Link = std::uint32_t;
+
+        static constexpr Link MARK = Link{1} << 31;
+        static constexpr Link NIL = MARK - 1;
+        static constexpr Link HEAD = NIL - 1;
+
+        struct Node {
+            Node(const K& key, const V& value, std::size_t height) :
+                    key(key),
+                    value(value),
+                    height(height) {}
+
+            const K key;
+            const V value;
+            const std::size_t height;
+            /** The inserter and the eraser; whoever finishes last retires the node. */
+            std::atomic<int> owners{2};
+            std::array<std::atomic<Link>, MAX_LEVEL> next{};
+        };
+
+        using Path = std::array<Link, MAX_LEVEL>;
+
+    public:
+        explicit SkipList(Domain& domain) :
+                m_domain(&domain) {
+            for (auto& link: m_head) {
+                link.store(NIL, std::memory_order_relaxed);
+            }
+        }
+
+        SkipList(const SkipList&) = delete;
+        SkipList& operator=(const SkipList&) = delete;
+
+        /**
+         * Waits for the erased nodes still in their grace period, so call it from a
+         * thread that is not an online reader. No thread may still use the list.
+         */
+        ~SkipList() {
+            m_domain->barrier();
+            for (auto index = link_of(m_head[0]); index != NIL;) {
+                const auto next = link_of(node(index).next[0]);
+                m_pool.deallocate(index);
+                index = next;
+            }
+        }
+
+    public:
+        /**
+         * Returns true if it inserted, false if 'key' was present, nullopt if the pool
+         * is exhausted even after reclaiming the nodes whose grace period has ended.
+         */
+        std::optional<bool> insert(const K& key, const V& value) {
+            const auto height = random_height();
+            auto allocated = m_pool.allocate(key, value, height);
+            if (!allocated.has_value() && m_domain->reclaim() != 0) {
+                allocated = m_pool.allocate(key, value, height);
+            }
+            if (!allocated.has_value()) {
+                return std::nullopt;
+            }
+
+            const auto index = static_cast<Link>(allocated.value());
+            auto& inserted = node(index);
+            Path preds{};
+            Path succs{};
+            while (true) {
+                if (find(key, preds, succs)) {
+                    // Never published, so it can go straight back.
+                    m_pool.deallocate(index);
+                    return false;
+                }
+
+                for (std::size_t level = 0; level < inserted.height; ++level) {
+                    inserted.next[level].store(succs[level], std::memory_order_relaxed);
+                }
+                auto expected = succs[0];
+                if (next_of(preds[0], 0).compare_exchange_strong(expected, index, std::memory_order_release, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            m_size.fetch_add(1, std::memory_order_relaxed);
+
+            // Present from here on; the upper levels only speed up searches.
+            for (std::size_t level = 1; level < inserted.height && link_up(index, level, preds, succs); ++level) {}
+            release(index);
+            return true;
+        }
+
+        bool erase(const K& key) {
+            Path preds{};
+            Path succs{};
+            if (!find(key, preds, succs)) {
+                return false;
+            }
+
+            const auto index = succs[0];
+            auto& erased = node(index);
+            for (auto level = erased.height - 1; level > 0; --level) {
+                auto link = erased.next[level].load(std::memory_order_acquire);
+                while ((link & MARK) == 0 && !erased.next[level].compare_exchange_weak(link, link | MARK, std::memory_order_acq_rel)) {}
+            }
+
+            // Marking level 0 is the erase; a racing erase of the same node loses here.
+            auto link = erased.next[0].load(std::memory_order_acquire);
+            do {
+                if ((link & MARK) != 0) {
+                    return false;
+                }
+            } while (!erased.next[0].compare_exchange_weak(link, link | MARK, std::memory_order_acq_rel));
+
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            release(index);
+            return true;
+        }
+
+        [[nodiscard]]
+        std::optional<V> find(const K& key) const {
+            const auto index = lower_bound(key);
+            if (index == NIL || m_less(key, node(index).key)) {
+                return std::nullopt;
+            }
+            return node(index).value;
+        }
+
+        [[nodiscard]]
+        bool contains(const K& key) const {
+            return find(key).has_value();
+        }
+
+        /**
+         * The smallest element, e.g. the best level of a book side.
+         */
+        [[nodiscard]]
+        std::optional<std::pair<K, V>> front() const {
+            for (auto index = link_of(m_head[0]); index != NIL;) {
+                const auto next = node(index).next[0].load(std::memory_order_acquire);
+                if ((next & MARK) == 0) {
+                    return std::pair<K, V>(node(index).key, node(index).value);
+                }
+                index = next & ~MARK;
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * Calls fn(key, value) in order for the keys in [from, to); returns how many it
+         * visited. Weakly consistent: concurrent inserts and erases may or may not show.
+         */
+        template<typename F>
+        std::size_t range(const K& from, const K& to, F&& fn) const {
+            std::size_t visited = 0;
+            for (auto index = lower_bound(from); index != NIL && m_less(node(index).key, to);) {
+                const auto next = node(index).next[0].load(std::memory_order_acquire);
+                if ((next & MARK) == 0) {
+                    fn(node(index).key, node(index).value);
+                    ++visited;
+                }
+                index = next & ~MARK;
+            }
+            return visited;
+        }
+
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            return m_size.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        static constexpr std::size_t capacity() noexcept {
+            return N;
+        }
+
+    private:
+        Node& node(Link index) noexcept {
+            return m_pool.at(index);
+        }
+
+        const Node& node(Link index) const noexcept {
+            return m_pool.at(index);
+        }
+
+        std::atomic<Link>& next_of(Link index, std::size_t level) noexcept {
+            return index == HEAD ? m_head[level] : node(index).next[level];
+        }
+
+        const std::atomic<Link>& next_of(Link index, std::size_t level) const noexcept {
+            return index == HEAD ? m_head[level] : node(index).next[level];
+        }
+
+        static Link link_of(const std::atomic<Link>& link) noexcept {
+            return link.load(std::memory_order_acquire) & ~MARK;
+        }
+
+        /**
+         * First node not less than 'key', stepping over erased ones without unlinking
+         * them.
+         */
+        Link lower_bound(const K& key) const {
+            auto pred = HEAD;
+            auto curr = NIL;
+            for (auto level = MAX_LEVEL; level-- > 0;) {
+                curr = link_of(next_of(pred, level));
+                while (curr != NIL) {
+                    const auto succ = node(curr).next[level].load(std::memory_order_acquire);
+                    if ((succ & MARK) != 0) {
+                        curr = succ & ~MARK;
+                    } else if (m_less(node(curr).key, key)) {
+                        pred = curr;
+                        curr = succ;
+                    } else {
+                        break;
+                    }
+                }
+            }
+            return curr;
+        }
+
+        /**
+         * Fills the predecessors and successors of 'key' on every level, unlinking
+         * erased nodes on the way. With 'cleanup' it also walks past nodes equal to
+         * 'key', so an erased duplicate behind a live one is unlinked as well.
+         */
+        bool find(const K& key, Path& preds, Path& succs, bool cleanup = false) {
+            while (true) {
+                if (const auto found = try_find(key, preds, succs, cleanup); found.has_value()) {
+                    return found.value();
+                }
+            }
+        }
+
+        /**
+         * One pass of find(); nullopt when an unlink lost a race and it must restart.
+         */
+        std::optional<bool> try_find(const K& key, Path& preds, Path& succs, bool cleanup) {
+            // Last node less than 'key': where the next level down starts.
+            auto start = HEAD;
+            for (auto level = MAX_LEVEL; level-- > 0;) {
+                auto pred = start;
+                auto curr = link_of(next_of(pred, level));
+                while (curr != NIL) {
+                    const auto succ = node(curr).next[level].load(std::memory_order_acquire);
+                    if ((succ & MARK) != 0) {
+                        auto expected = curr;
+                        if (!next_of(pred, level).compare_exchange_strong(expected, succ & ~MARK, std::memory_order_acq_rel)) {
+                            return std::nullopt;
+                        }
+                        curr = succ & ~MARK;
+                    } else if (m_less(node(curr).key, key)) {
+                        start = pred = curr;
+                        curr = succ;
+                    } else if (cleanup && !m_less(key, node(curr).key)) {
+                        pred = curr;
+                        curr = succ;
+                    } else {
+                        break;
+                    }
+                }
+                preds[level] = pred;
+                succs[level] = curr;
+            }
+            return succs[0] != NIL && !m_less(key, node(succs[0]).key);
+        }
+
+        /**
+         * Links the inserted node on 'level'; false once an erase has started on it.
+         */
+        bool link_up(Link index, std::size_t level, Path& preds, Path& succs) {
+            auto& inserted = node(index);
+            while (true) {
+                auto link = inserted.next[level].load(std::memory_order_acquire);
+                if ((link & MARK) != 0) {
+                    return false;
+                }
+                if (link != succs[level] && !inserted.next[level].compare_exchange_strong(link, succs[level], std::memory_order_acq_rel)) {
+                    continue;
+                }
+
+                auto expected = succs[level];
+                if (next_of(preds[level], level).compare_exchange_strong(expected, index, std::memory_order_release, std::memory_order_relaxed)) {
+                    return true;
+                }
+                if (!find(inserted.key, preds, succs) || succs[0] != index) {
+                    return false;
+                }
+            }
+        }
+
+        /**
+         * Drops one owner. The last one unlinks whatever is still linked (a level the
+         * inserter linked after the erase's own pass) and hands the node to RCU.
+         */
+        void release(Link index) {
+            if (node(index).owners.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+
+            Path preds{};
+            Path succs{};
+            (void) find(node(index).key, preds, succs, true);
+            m_domain->call_rcu([this, index]() { m_pool.deallocate(index); });
+            (void) m_domain->reclaim();
+        }
+
+        static std::size_t random_height() noexcept {
+            if (t_rng == 0) {
+                t_rng = static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1;
+            }
+            auto x = t_rng;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            t_rng = x;
+            // One level more with probability 1/4.
+            return std::min<std::size_t>(1 + std::countr_zero(x | (1u << 30)) / 2, MAX_LEVEL);
+        }
+
+        inline static thread_local std::uint32_t t_rng{};
+
+        Domain* m_domain;
+        [[no_unique_address]] Compare m_less{};
+        alignas (CACHE_LINE_SIZE) std::array<std::atomic<Link>, MAX_LEVEL> m_head{};
+        alignas (CACHE_LINE_SIZE) std::atomic<std::size_t> m_size{};
+        memory::ShmPool<Node, N> m_pool{};
+    };
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Definitions.h"
+#include "MPMC.h"
+#include "WorkStealingDeque.h"
+#include "os/Futex.h"
+#include "os/LinuxError.h"
+#include "os/Placement.h"
+
+namespace conq {
+    /**
+     * Counts the tasks spawned into it that have not finished; ThreadPool::wait()
+     * returns once it reaches zero.
+     */
+    class TaskGroup final {
+    public:
+        TaskGroup() = default;
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        [[nodiscard]]
+        bool done() const noexcept {
+            return m_pending.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        friend class ThreadPool;
+
+        std::atomic<std::size_t> m_pending{};
+    };
+
+    /**
+     * Fork-join executor. Each worker owns a WorkStealingDeque: tasks spawned from a
+     * worker go to its own deque and run LIFO there, idle workers steal from a random
+     * victim, and tasks submitted from outside the pool go through a shared
+     * MPMCBoundedQueue. Workers that find nothing park on a futex eventcount and are
+     * woken by the next submission. Workers may be pinned with a Placement each.
+     *
+     * wait() does not block a worker: it runs other tasks until the group is done, so
+     * recursive fork-join does not deadlock with a fixed number of threads.
+     */
+    class ThreadPool final {
+    private:
+        struct Job {
+            std::function<void()> fn;
+            TaskGroup* group;
+        };
+
+        struct alignas (CACHE_LINE_SIZE) Worker {
+            WorkStealingDeque<Job*> deque{};
+            std::thread thread{};
+        };
+
+        static constexpr std::size_t INJECT_LEN = 1024;
+        static constexpr int SPINS_BEFORE_PARK = 64;
+
+        explicit ThreadPool(std::size_t workers) :
+                m_workers(workers) {
+            for (auto& worker: m_workers) {
+                worker = std::make_unique<Worker>();
+            }
+        }
+
+    public:
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Runs every task already queued, then joins the workers.
+         */
+        ~ThreadPool() {
+            m_stop.store(true, std::memory_order_seq_cst);
+            notify(INT_MAX);
+            for (auto& worker: m_workers) {
+                if (worker->thread.joinable()) {
+                    worker->thread.join();
+                }
+            }
+        }
+
+    public:
+        /**
+         * Queues 'fn' as part of 'group'. From a worker of this pool it goes to that
+         * worker's deque; from any other thread to the shared queue, waiting for room
+         * if that is full.
+         */
+        template<typename F>
+        void spawn(TaskGroup& group, F&& fn) {
+            group.m_pending.fetch_add(1, std::memory_order_relaxed);
+            auto job = new Job{std::forward<F>(fn), &group};
+
+            if (t_pool == this) {
+                m_workers[t_index]->deque.push(job);
+            } else {
+                while (!m_injected.try_push(job)) {
+                    std::this_thread::yield();
+                }
+            }
+            notify(1);
+        }
+
+        /**
+         * Fire-and-forget task; it still counts for the destructor.
+         */
+        template<typename F>
+        void submit(F&& fn) {
+            spawn(m_detached, std::forward<F>(fn));
+        }
+
+        /**
+         * Runs pool tasks on the calling thread until 'group' is done.
+         */
+        void wait(TaskGroup& group) {
+            int idle = 0;
+            while (!group.done()) {
+                if (run_one()) {
+                    idle = 0;
+                    continue;
+                }
+                if (++idle < SPINS_BEFORE_PARK) {
+                    cpu_relax();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        [[nodiscard]]
+        std::size_t workers() const noexcept {
+            return m_workers.size();
+        }
+
+        /**
+         * Index of the calling worker in this pool, or -1 outside it.
+         */
+        [[nodiscard]]
+        int current_worker() const noexcept {
+            return t_pool == this ? static_cast<int>(t_index) : -1;
+        }
+
+    public:
+        /**
+         * Starts 'workers' threads. Worker i applies placements[i % placements.size()]
+         * when placements are given; a placement failure stops the pool and is
+         * returned.
+         */
+        [[nodiscard]]
+        static std::expected<std::unique_ptr<ThreadPool>, LinuxError> create(std::size_t workers, std::span<const Placement> placements = {}) {
+            if (workers == 0) {
+                return LinuxError::unexpect(EINVAL);
+            }
+
+            std::unique_ptr<ThreadPool> pool(new ThreadPool(workers));
+            for (std::size_t i = 0; i < workers; ++i) {
+                const auto placement = placements.empty() ? Placement{} : placements[i % placements.size()];
+                auto thread = spawn_thread(placement, [raw = pool.get(), i]() {
+                    raw->run(i);
+                });
+                if (!thread.has_value()) {
+                    return std::unexpected(thread.error());
+                }
+                pool->m_workers[i]->thread = std::move(thread.value());
+            }
+            return pool;
+        }
+
+    private:
+        void run(std::size_t index) {
+            t_pool = this;
+            t_index = index;
+            t_rng = static_cast<std::uint32_t>(index * 2654435761u + 1);
+
+            int idle = 0;
+            while (true) {
+                if (run_one()) {
+                    idle = 0;
+                    continue;
+                }
+                if (++idle < SPINS_BEFORE_PARK) {
+                    cpu_relax();
+                    continue;
+                }
+
+                idle = 0;
+                if (!park()) {
+                    return;
+                }
+            }
+        }
+
+        /**
+         * Sleeps until new work may be available; false once the pool stops and no
+         * work is left.
+         */
+        bool park() {
+            const auto epoch = m_epoch.load(std::memory_order_seq_cst);
+            m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+            // Re-check after registering: a submit that raced with us either is visible
+            // now or sees the sleeper and wakes us.
+            const bool stop = m_stop.load(std::memory_order_seq_cst);
+            if (!has_work()) {
+                if (stop) {
+                    m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+                    return false;
+                }
+                (void) futex::wait(m_epoch, epoch);
+            }
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void notify(int count) {
+            m_epoch.fetch_add(1, std::memory_order_seq_cst);
+            if (m_sleepers.load(std::memory_order_seq_cst) != 0) {
+                futex::wake(m_epoch, count);
+            }
+        }
+
+        bool has_work() const {
+            if (!m_injected.empty()) {
+                return true;
+            }
+            for (const auto& worker: m_workers) {
+                if (!worker->deque.empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool run_one() {
+            const auto job = find_job();
+            if (job == nullptr) {
+                return false;
+            }
+
+            std::unique_ptr<Job> owned(job);
+            owned->fn();
+            owned->group->m_pending.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+
+        Job* find_job() {
+            const bool worker = t_pool == this;
+            if (worker) {
+                if (const auto job = m_workers[t_index]->deque.pop(); job.has_value()) {
+                    return job.value();
+                }
+            }
+            if (auto job = m_injected.try_pop(); job.has_value()) {
+                return job.value();
+            }
+
+            // Random starting victim, then every other worker once.
+            const auto count = m_workers.size();
+            const auto start = worker ? next_random() % count : 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto victim = (start + i) % count;
+                if (worker && victim == t_index) {
+                    continue;
+                }
+                if (const auto job = m_workers[victim]->deque.steal(); job.has_value()) {
+                    return job.value();
+                }
+            }
+            return nullptr;
+        }
+
+        static std::uint32_t next_random() noexcept {
+            // xorshift32; per thread, so no shared state on the steal path.
+            auto x = t_rng;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            t_rng = x;
+            return x;
+        }
+
+        inline static thread_local ThreadPool* t_pool{};
+        inline static thread_local std::size_t t_index{};
+        inline static thread_local std::uint32_t t_rng{1};
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        MPMCBoundedQueue<Job*, INJECT_LEN> m_injected{};
+        TaskGroup m_detached{};
+        alignas (CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_epoch{};
+        std::atomic<std::uint32_t> m_sleepers{};
+        std::atomic<bool> m_stop{};
+    };
+}
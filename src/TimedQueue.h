@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "Definitions.h"
+#include "MPMC.h"
+#include "metrics/Histogram.h"
+#include "os/Tsc.h"
+
+namespace conq {
+    template<typename T>
+    struct Stamped final {
+        T value{};
+        std::uint64_t stamp{};
+    };
+
+    /**
+     * Bounded queue that stamps every element with the TSC when it is published and
+     * records its residence time (publish to consume, in ns) into a histogram when it
+     * is popped. Any of the bounded queues can be underneath; the histogram is inline,
+     * so a TimedQueue placed in ShMem can be scraped like a metrics::Registry.
+     */
+    template<QElement T, std::size_t LEN, template<typename, std::size_t> class Queue = MPMCBoundedQueue>
+    requires PowerOfTwo<LEN>
+    class TimedQueue final {
+    public:
+        // Calibrate now rather than on the first pop.
+        TimedQueue() {
+            (void) Tsc::calibration();
+        }
+
+        TimedQueue(const TimedQueue&) = delete;
+        TimedQueue& operator=(const TimedQueue&) = delete;
+
+    public:
+        template<typename U>
+        requires std::convertible_to<U, T>
+        bool try_push(U &&value) {
+            return m_queue.try_push(Stamped<T>{std::forward<U>(value), Tsc::now()});
+        }
+
+        std::optional<T> try_pop() {
+            auto stamped = m_queue.try_pop();
+            if (!stamped.has_value()) {
+                return std::nullopt;
+            }
+
+            m_residence.record(Tsc::calibration().since(stamped->stamp));
+            return std::move(stamped->value);
+        }
+
+        [[nodiscard]]
+        const metrics::Histogram& residence() const noexcept {
+            return m_residence;
+        }
+
+    private:
+        Queue<Stamped<T>, LEN> m_queue;
+        metrics::Histogram m_residence{};
+    };
+}
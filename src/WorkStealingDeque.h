@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "Definitions.h"
+#include "QueueStats.h"
+
+namespace conq {
+    /**
+     * Chase-Lev work-stealing deque (with the C11 orderings of Lê et al., "Correct and
+     * Efficient Work-Stealing for Weak Memory Models"). The owning thread pushes and
+     * pops at the bottom, LIFO, which keeps freshly spawned work in its cache; any
+     * other thread steals from the top, FIFO, taking the oldest and usually largest
+     * pieces of work.
+     *
+     * The buffer grows without bound. Elements are copied in and out of atomics, so
+     * T must be trivially copyable; pointers and indices are the usual choice. Buffers
+     * outgrown by the owner are kept until destruction because a thief may still be
+     * reading one.
+     */
+    template<typename T, typename Stats = NoStats>
+    requires std::is_trivially_copyable_v<T>
+    class WorkStealingDeque final {
+    public:
+        explicit WorkStealingDeque(std::size_t capacity = 256) {
+            auto buffer = std::make_unique<Buffer>(std::bit_ceil(std::max<std::size_t>(capacity, 2)));
+            m_buffer.store(buffer.get(), std::memory_order_relaxed);
+            m_buffers.push_back(std::move(buffer));
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    public:
+        /**
+         * Owner only.
+         */
+        void push(T value) {
+            const auto bottom = m_bottom.load(std::memory_order_relaxed);
+            const auto top = m_top.load(std::memory_order_acquire);
+            auto buffer = m_buffer.load(std::memory_order_relaxed);
+            if (bottom - top > static_cast<std::int64_t>(buffer->capacity()) - 1) {
+                buffer = grow(buffer, top, bottom);
+            }
+
+            buffer->put(bottom, value);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            m_stats.on(QueueEvent::Push);
+            m_stats.depth(static_cast<std::size_t>(bottom + 1 - top));
+        }
+
+        /**
+         * Owner only. Takes the most recently pushed element.
+         */
+        std::optional<T> pop() {
+            const auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            const auto buffer = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto top = m_top.load(std::memory_order_relaxed);
+
+            if (top > bottom) {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                m_stats.on(QueueEvent::Empty);
+                return std::nullopt;
+            }
+
+            const auto value = buffer->get(bottom);
+            if (top == bottom) {
+                // Last element: race the thieves for it.
+                const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                if (!won) {
+                    m_stats.on(QueueEvent::CasRetry);
+                    return std::nullopt;
+                }
+            }
+            m_stats.on(QueueEvent::Pop);
+            return value;
+        }
+
+        /**
+         * Any thread. Takes the oldest element; nullopt if the deque is empty or another
+         * thread won the race for that element, in which case the caller moves on to the
+         * next victim rather than retrying here.
+         */
+        std::optional<T> steal() {
+            auto top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto bottom = m_bottom.load(std::memory_order_acquire);
+            if (top >= bottom) {
+                m_stats.on(QueueEvent::Empty);
+                return std::nullopt;
+            }
+
+            const auto buffer = m_buffer.load(std::memory_order_acquire);
+            const auto value = buffer->get(top);
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                m_stats.on(QueueEvent::CasRetry);
+                return std::nullopt;
+            }
+            m_stats.on(QueueEvent::Pop);
+            return value;
+        }
+
+        /**
+         * Approximate when other threads are active.
+         */
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            const auto bottom = m_bottom.load(std::memory_order_relaxed);
+            const auto top = m_top.load(std::memory_order_relaxed);
+            return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+        }
+
+        [[nodiscard]]
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        [[nodiscard]]
+        const Stats& stats() const noexcept {
+            return m_stats;
+        }
+
+    private:
+        class Buffer final {
+        public:
+            explicit Buffer(std::size_t capacity) :
+                    m_mask(capacity - 1),
+                    m_slots(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+            [[nodiscard]]
+            std::size_t capacity() const noexcept {
+                return m_mask + 1;
+            }
+
+            void put(std::int64_t index, T value) noexcept {
+                m_slots[static_cast<std::size_t>(index) & m_mask].store(value, std::memory_order_relaxed);
+            }
+
+            [[nodiscard]]
+            T get(std::int64_t index) const noexcept {
+                return m_slots[static_cast<std::size_t>(index) & m_mask].load(std::memory_order_relaxed);
+            }
+
+        private:
+            std::size_t m_mask;
+            std::unique_ptr<std::atomic<T>[]> m_slots;
+        };
+
+        Buffer* grow(Buffer* old, std::int64_t top, std::int64_t bottom) {
+            auto bigger = std::make_unique<Buffer>(old->capacity() * 2);
+            for (auto i = top; i < bottom; ++i) {
+                bigger->put(i, old->get(i));
+            }
+
+            const auto raw = bigger.get();
+            m_buffers.push_back(std::move(bigger));
+            m_buffer.store(raw, std::memory_order_release);
+            return raw;
+        }
+
+        alignas (CACHE_LINE_SIZE) std::atomic<std::int64_t> m_top{};
+        alignas (CACHE_LINE_SIZE) std::atomic<std::int64_t> m_bottom{};
+        alignas (CACHE_LINE_SIZE) std::atomic<Buffer*> m_buffer{};
+        std::vector<std::unique_ptr<Buffer>> m_buffers;
+        [[no_unique_address]] Stats m_stats{};
+    };
+}
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <tuple>
+#include <utility>
+
+#include "allocation/SeqAllocator.h"
+#include "allocation/ShmPool.h"
+
+namespace conq::memory {
+    template<std::size_t SIZE, std::size_t ALIGN>
+    struct alignas (ALIGN) Block final {
+        // Left uninitialized on purpose: blocks are raw storage handed out by resources.
+        Block() {}
+
+        std::byte data[SIZE];
+    };
+
+    /**
+     * Bump-pointer resource. Deallocation is a no-op; memory is returned all at once
+     * by release() or the destructor. Starts from an optional caller-provided buffer
+     * and grows with geometrically increasing chunks taken from the upstream resource.
+     */
+    class MonotonicArena final : public std::pmr::memory_resource {
+    public:
+        explicit MonotonicArena(std::size_t chunk_size = 4096,
+                                std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept:
+                m_upstream(upstream),
+                m_initial_chunk_size(chunk_size),
+                m_next_chunk_size(chunk_size) {}
+
+        explicit MonotonicArena(std::span<std::byte> buffer,
+                                std::pmr::memory_resource* upstream = std::pmr::null_memory_resource()) noexcept:
+                m_upstream(upstream),
+                m_buffer(buffer),
+                m_initial_chunk_size(std::max(buffer.size(), std::size_t{64})),
+                m_next_chunk_size(m_initial_chunk_size),
+                m_cursor(buffer.data()),
+                m_end(buffer.data() + buffer.size()) {}
+
+        MonotonicArena(const MonotonicArena&) = delete;
+        MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+        ~MonotonicArena() override {
+            release();
+        }
+
+    public:
+        void release() noexcept {
+            while (m_chunks != nullptr) {
+                const auto next = m_chunks->next;
+                m_upstream->deallocate(m_chunks, m_chunks->size, alignof(Chunk));
+                m_chunks = next;
+            }
+
+            m_cursor = m_buffer.data();
+            m_end = m_buffer.data() + m_buffer.size();
+            m_next_chunk_size = m_initial_chunk_size;
+        }
+
+        [[nodiscard]]
+        std::size_t remaining() const noexcept {
+            return static_cast<std::size_t>(m_end - m_cursor);
+        }
+
+    private:
+        struct Chunk {
+            Chunk* next;
+            std::size_t size;
+        };
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (auto p = bump(bytes, alignment)) {
+                return p;
+            }
+
+            grow(bytes + alignment);
+            return bump(bytes, alignment);
+        }
+
+        void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+        [[nodiscard]]
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        void* bump(std::size_t bytes, std::size_t alignment) noexcept {
+            void* p = m_cursor;
+            auto space = remaining();
+            if (std::align(alignment, bytes, p, space) == nullptr) {
+                return nullptr;
+            }
+
+            m_cursor = static_cast<std::byte*>(p) + bytes;
+            return p;
+        }
+
+        void grow(std::size_t min_bytes) {
+            const auto size = std::max(m_next_chunk_size, min_bytes + sizeof(Chunk));
+            auto chunk = static_cast<Chunk*>(m_upstream->allocate(size, alignof(Chunk)));
+            chunk->next = m_chunks;
+            chunk->size = size;
+            m_chunks = chunk;
+
+            m_cursor = reinterpret_cast<std::byte*>(chunk + 1);
+            m_end = reinterpret_cast<std::byte*>(chunk) + size;
+            m_next_chunk_size = size * 2;
+        }
+
+        std::pmr::memory_resource* m_upstream;
+        std::span<std::byte> m_buffer{};
+        std::size_t m_initial_chunk_size;
+        std::size_t m_next_chunk_size;
+        std::byte* m_cursor{};
+        std::byte* m_end{};
+        Chunk* m_chunks{};
+    };
+
+    /**
+     * Single-threaded pool of N blocks of BLOCK_SIZE bytes backed by SeqAllocator.
+     * Requests that do not fit a block, or arrive when the pool is exhausted, go upstream.
+     */
+    template<std::size_t BLOCK_SIZE, std::size_t N, std::size_t ALIGN = alignof(std::max_align_t)>
+    class FixedPoolResource final : public std::pmr::memory_resource {
+    public:
+        explicit FixedPoolResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept:
+                m_upstream(upstream) {}
+
+        FixedPoolResource(const FixedPoolResource&) = delete;
+        FixedPoolResource& operator=(const FixedPoolResource&) = delete;
+
+    public:
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            return m_pool.size();
+        }
+
+    private:
+        using Storage = Block<BLOCK_SIZE, ALIGN>;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (bytes <= BLOCK_SIZE && alignment <= ALIGN) {
+                if (auto p = m_pool.allocate()) {
+                    return p;
+                }
+            }
+
+            return m_upstream->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            const auto block = static_cast<Storage*>(p);
+            if (m_pool.is_in_range(block)) {
+                m_pool.deallocate(block);
+                return;
+            }
+
+            m_upstream->deallocate(p, bytes, alignment);
+        }
+
+        [[nodiscard]]
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource* m_upstream;
+        SeqAllocator<Storage, N> m_pool;
+    };
+
+    /**
+     * Lock-free variant of FixedPoolResource backed by ShmPool, for memory that is
+     * allocated on one thread and released on another (e.g. SPSCQueue nodes).
+     */
+    template<std::size_t BLOCK_SIZE, std::size_t N, std::size_t ALIGN = alignof(std::max_align_t)>
+    class ConcurrentPoolResource final : public std::pmr::memory_resource {
+    public:
+        explicit ConcurrentPoolResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept:
+                m_upstream(upstream) {}
+
+        ConcurrentPoolResource(const ConcurrentPoolResource&) = delete;
+        ConcurrentPoolResource& operator=(const ConcurrentPoolResource&) = delete;
+
+    private:
+        using Storage = Block<BLOCK_SIZE, ALIGN>;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (bytes <= BLOCK_SIZE && alignment <= ALIGN) {
+                if (const auto index = m_pool.allocate()) {
+                    return &m_pool.at(index.value());
+                }
+            }
+
+            return m_upstream->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            const auto block = static_cast<Storage*>(p);
+            if (m_pool.is_in_range(block)) {
+                m_pool.deallocate(m_pool.index_of(block));
+                return;
+            }
+
+            m_upstream->deallocate(p, bytes, alignment);
+        }
+
+        [[nodiscard]]
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource* m_upstream;
+        ShmPool<Storage, N> m_pool;
+    };
+
+    /**
+     * Single-threaded multi-size-class pool: one SeqAllocator of N blocks per size in
+     * SIZES (ascending). A request is served by the smallest class that fits and has
+     * room; anything larger than the last class goes upstream.
+     */
+    template<std::size_t N, std::size_t... SIZES>
+    requires (sizeof...(SIZES) > 0)
+    class SizeClassResource final : public std::pmr::memory_resource {
+        static constexpr std::array<std::size_t, sizeof...(SIZES)> CLASSES{SIZES...};
+        static_assert(std::ranges::is_sorted(CLASSES), "Size classes must be ascending");
+
+        static constexpr std::size_t ALIGN = alignof(std::max_align_t);
+
+    public:
+        explicit SizeClassResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()):
+                m_upstream(upstream),
+                m_classes(std::make_unique<Classes>()) {}
+
+        SizeClassResource(const SizeClassResource&) = delete;
+        SizeClassResource& operator=(const SizeClassResource&) = delete;
+
+    private:
+        using Classes = std::tuple<SeqAllocator<Block<SIZES, ALIGN>, N>...>;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (alignment <= ALIGN) {
+                if (auto p = allocate_from<0>(bytes)) {
+                    return p;
+                }
+            }
+
+            return m_upstream->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            if (deallocate_from<0>(p)) {
+                return;
+            }
+
+            m_upstream->deallocate(p, bytes, alignment);
+        }
+
+        [[nodiscard]]
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        template<std::size_t I>
+        void* allocate_from(std::size_t bytes) noexcept {
+            if constexpr (I == CLASSES.size()) {
+                return nullptr;
+            } else {
+                if (bytes <= CLASSES[I]) {
+                    if (auto p = std::get<I>(*m_classes).allocate()) {
+                        return p;
+                    }
+                }
+
+                return allocate_from<I + 1>(bytes);
+            }
+        }
+
+        template<std::size_t I>
+        bool deallocate_from(void* p) noexcept {
+            if constexpr (I == CLASSES.size()) {
+                return false;
+            } else {
+                auto& allocator = std::get<I>(*m_classes);
+                const auto block = static_cast<Block<CLASSES[I], ALIGN>*>(p);
+                if (allocator.is_in_range(block)) {
+                    allocator.deallocate(block);
+                    return true;
+                }
+
+                return deallocate_from<I + 1>(p);
+            }
+        }
+
+        std::pmr::memory_resource* m_upstream;
+        std::unique_ptr<Classes> m_classes;
+    };
+
+    /**
+     * Standard allocator over a std::pmr::memory_resource. Unlike polymorphic_allocator
+     * it does no uses-allocator construction, and it defaults to the process default
+     * resource so it can be used where containers default-construct their allocator.
+     */
+    template<typename T>
+    class ResourceAllocator {
+    public:
+        using value_type = T;
+
+        ResourceAllocator() noexcept:
+                m_resource(std::pmr::get_default_resource()) {}
+
+        ResourceAllocator(std::pmr::memory_resource* resource) noexcept:
+                m_resource(resource) {}
+
+        template<typename U>
+        ResourceAllocator(const ResourceAllocator<U>& other) noexcept:
+                m_resource(other.resource()) {}
+
+    public:
+        [[nodiscard]]
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(m_resource->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept {
+            m_resource->deallocate(p, n * sizeof(T), alignof(T));
+        }
+
+        [[nodiscard]]
+        std::pmr::memory_resource* resource() const noexcept {
+            return m_resource;
+        }
+
+        template<typename U>
+        bool operator==(const ResourceAllocator<U>& other) const noexcept {
+            return *m_resource == *other.resource();
+        }
+
+    private:
+        std::pmr::memory_resource* m_resource;
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <bitset>
 #include <cstddef>
 #include <stacktrace>
 
@@ -119,6 +120,7 @@ namespace conq::memory {
                 m_free[i] = reinterpret_cast<T*>(&m_pool[i * sizeof(T)]);
                 m_index++;
             }
+            m_released.set();
         }
 
         SeqAllocator(const SeqAllocator&) = delete;
@@ -140,6 +142,7 @@ namespace conq::memory {
             --m_index;
             T* ptr = m_free[m_index];
             m_free[m_index] = nullptr;
+            m_released.reset(slot_index(ptr));
 
             new (ptr) T(std::forward<Args>(args)...);
             return ptr;
@@ -212,7 +215,12 @@ namespace conq::memory {
         }
 
         bool is_free(const T* ptr) const noexcept {
-            return std::find(m_free.begin(), m_free.begin()+m_index, ptr) != m_free.begin()+m_index;
+            return m_released.test(slot_index(ptr));
+        }
+
+        [[nodiscard]]
+        std::size_t slot_index(const T* ptr) const noexcept {
+            return (reinterpret_cast<const char*>(ptr) - begin()) / sizeof(T);
         }
 
         [[nodiscard]]
@@ -229,11 +237,13 @@ namespace conq::memory {
         void unchecked_deallocate(T* ptr) noexcept {
             ptr->~T();
             m_free[m_index] = ptr;
+            m_released.set(slot_index(ptr));
             ++m_index;
         }
 
-        char m_pool[sizeof(T) * N]{};
+        alignas(T) char m_pool[sizeof(T) * N]{};
         std::array<T*, N> m_free;
+        std::bitset<N> m_released;
         std::size_t m_index{0};
     };
 
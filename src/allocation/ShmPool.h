@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "Definitions.h"
+
+namespace conq::memory {
+    /**
+     * Fixed-capacity object pool that holds no pointers, so it can be placed in a ShMem
+     * segment and shared between processes mapping it at different addresses.
+     * Objects are addressed by index; the free list is a Treiber stack whose head
+     * carries an ABA tag in its upper 32 bits.
+     */
+    template<typename T, std::size_t N>
+    requires (N > 0 && N < UINT32_MAX)
+    class ShmPool final {
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ShmPool requires lock-free 64-bit atomics");
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "ShmPool requires lock-free 32-bit atomics");
+
+    public:
+        using Index = std::uint32_t;
+
+        ShmPool() noexcept {
+            for (Index i = 0; i < N; ++i) {
+                m_next[i].store(i + 1, std::memory_order_relaxed);
+            }
+            m_head.store(0, std::memory_order_release);
+        }
+
+        ShmPool(const ShmPool&) = delete;
+        ShmPool& operator=(const ShmPool&) = delete;
+        ShmPool(ShmPool&&) = delete;
+        ShmPool& operator=(ShmPool&&) = delete;
+
+    public:
+        template <typename... Args>
+        [[nodiscard]]
+        std::optional<Index> allocate(Args&&... args) {
+            auto head = m_head.load(std::memory_order_acquire);
+            for (;;) {
+                const auto index = index_of(head);
+                if (index == END) {
+                    return std::nullopt;
+                }
+
+                const auto next = m_next[index].load(std::memory_order_relaxed);
+                if (m_head.compare_exchange_weak(head, pack(tag_of(head) + 1, next),
+                                                 std::memory_order_acquire, std::memory_order_acquire)) {
+                    new (slot(index)) T(std::forward<Args>(args)...);
+                    return index;
+                }
+            }
+        }
+
+        void deallocate(Index index) noexcept {
+            slot(index)->~T();
+
+            auto head = m_head.load(std::memory_order_relaxed);
+            do {
+                m_next[index].store(index_of(head), std::memory_order_relaxed);
+            } while (!m_head.compare_exchange_weak(head, pack(tag_of(head) + 1, index),
+                                                   std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        [[nodiscard]]
+        T& at(Index index) noexcept {
+            return *slot(index);
+        }
+
+        [[nodiscard]]
+        const T& at(Index index) const noexcept {
+            return *slot(index);
+        }
+
+        T& operator[](Index index) noexcept {
+            return at(index);
+        }
+
+        [[nodiscard]]
+        bool is_in_range(Index index) const noexcept {
+            return index < N;
+        }
+
+        [[nodiscard]]
+        bool is_in_range(const T* ptr) const noexcept {
+            const auto p = reinterpret_cast<const std::byte*>(ptr);
+            return p >= &m_storage[0] && p < &m_storage[0] + sizeof(m_storage);
+        }
+
+        [[nodiscard]]
+        Index index_of(const T* ptr) const noexcept {
+            return static_cast<Index>((reinterpret_cast<const std::byte*>(ptr) - &m_storage[0]) / sizeof(T));
+        }
+
+        static constexpr std::size_t capacity() noexcept {
+            return N;
+        }
+
+    private:
+        static constexpr Index END = N;
+
+        static constexpr std::uint64_t pack(std::uint64_t tag, Index index) noexcept {
+            return (tag << 32) | index;
+        }
+
+        static constexpr Index index_of(std::uint64_t head) noexcept {
+            return static_cast<Index>(head);
+        }
+
+        static constexpr std::uint64_t tag_of(std::uint64_t head) noexcept {
+            return head >> 32;
+        }
+
+        T* slot(Index index) noexcept {
+            return std::launder(reinterpret_cast<T*>(&m_storage[index * sizeof(T)]));
+        }
+
+        const T* slot(Index index) const noexcept {
+            return std::launder(reinterpret_cast<const T*>(&m_storage[index * sizeof(T)]));
+        }
+
+        alignas (CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_head{pack(0, END)};
+        alignas (CACHE_LINE_SIZE) std::array<std::atomic<Index>, N> m_next;
+        alignas (T) std::byte m_storage[sizeof(T) * N];
+    };
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <ostream>
+
+#include "Definitions.h"
+
+namespace conq::memory {
+    struct SlabStats final {
+        std::size_t block_size{};
+        std::size_t allocations{};
+        std::size_t deallocations{};
+        std::size_t in_use{};
+        std::size_t peak_in_use{};
+        std::size_t slabs{};
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const SlabStats& obj) {
+        os << "Block: " << obj.block_size
+           << " Allocations: " << obj.allocations
+           << " Deallocations: " << obj.deallocations
+           << " In use: " << obj.in_use
+           << " Peak: " << obj.peak_in_use
+           << " Slabs: " << obj.slabs;
+        return os;
+    }
+
+    /**
+     * Variable-size block allocator for message buffers from 32 B to 64 KiB.
+     * Requests are rounded up to a size class (powers of two and the midpoints
+     * between them: 32, 48, 64, 96, ...), and every class carves its blocks out of
+     * slabs obtained from the upstream resource only when its free list is empty.
+     * Freed blocks are kept per class for reuse; slabs are returned on destruction.
+     * Requests above 64 KiB are forwarded upstream. Not thread-safe.
+     */
+    class SlabAllocator final : public std::pmr::memory_resource {
+    public:
+        static constexpr std::size_t MIN_BLOCK_SIZE = 32;
+        static constexpr std::size_t MAX_BLOCK_SIZE = 64 * 1024;
+        static constexpr std::size_t SLAB_SIZE = 64 * 1024;
+        static constexpr std::size_t MIN_BLOCKS_PER_SLAB = 4;
+        static constexpr std::size_t CLASSES = 2 * (std::bit_width(MAX_BLOCK_SIZE) - std::bit_width(MIN_BLOCK_SIZE)) + 1;
+
+        explicit SlabAllocator(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept:
+                m_upstream(upstream) {
+            for (std::size_t i = 0; i < CLASSES; ++i) {
+                m_classes[i].stats.block_size = class_size(i);
+            }
+        }
+
+        SlabAllocator(const SlabAllocator&) = delete;
+        SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+        ~SlabAllocator() override {
+            for (auto& size_class: m_classes) {
+                auto slab = size_class.slabs;
+                while (slab != nullptr) {
+                    const auto next = slab->next;
+                    m_upstream->deallocate(slab, slab->size, CACHE_LINE_SIZE);
+                    slab = next;
+                }
+            }
+        }
+
+    public:
+        /**
+         * Pre-populates the class serving 'size' with at least 'count' free blocks,
+         * so the first requests on a hot path do not reach the upstream resource.
+         */
+        void reserve(std::size_t size, std::size_t count) {
+            const auto index = class_index(size);
+            if (!index.has_value()) {
+                return;
+            }
+
+            auto& size_class = m_classes[index.value()];
+            std::size_t available = 0;
+            for (auto block = size_class.free; block != nullptr; block = block->next) {
+                ++available;
+            }
+
+            while (available < count) {
+                available += grow(index.value());
+            }
+        }
+
+        [[nodiscard]]
+        const SlabStats& stats(std::size_t size) const noexcept {
+            return m_classes[class_index(size).value_or(CLASSES - 1)].stats;
+        }
+
+        [[nodiscard]]
+        std::array<SlabStats, CLASSES> stats() const noexcept {
+            std::array<SlabStats, CLASSES> result{};
+            for (std::size_t i = 0; i < CLASSES; ++i) {
+                result[i] = m_classes[i].stats;
+            }
+            return result;
+        }
+
+        [[nodiscard]]
+        std::size_t oversized() const noexcept {
+            return m_oversized;
+        }
+
+        static constexpr std::optional<std::size_t> class_index(std::size_t size) noexcept {
+            if (size <= MIN_BLOCK_SIZE) {
+                return 0;
+            }
+            if (size > MAX_BLOCK_SIZE) {
+                return std::nullopt;
+            }
+
+            const auto order = static_cast<std::size_t>(std::bit_width(size - 1));
+            const auto midpoint = std::size_t{3} << (order - 2);
+            const auto index = 2 * (order - std::bit_width(MIN_BLOCK_SIZE) + 1);
+            return size <= midpoint ? index - 1 : index;
+        }
+
+        static constexpr std::size_t class_size(std::size_t index) noexcept {
+            const auto power = MIN_BLOCK_SIZE << ((index + 1) / 2);
+            return index % 2 == 0 ? power : power / 4 * 3;
+        }
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct Slab {
+            Slab* next;
+            std::size_t size;
+        };
+
+        struct SizeClass {
+            FreeBlock* free{};
+            Slab* slabs{};
+            SlabStats stats{};
+        };
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            const auto index = class_index(bytes);
+            if (!index.has_value() || alignment > alignof(std::max_align_t)) {
+                ++m_oversized;
+                return m_upstream->allocate(bytes, alignment);
+            }
+
+            auto& size_class = m_classes[index.value()];
+            if (size_class.free == nullptr) {
+                grow(index.value());
+            }
+
+            const auto block = size_class.free;
+            size_class.free = block->next;
+
+            auto& stats = size_class.stats;
+            ++stats.allocations;
+            ++stats.in_use;
+            stats.peak_in_use = std::max(stats.peak_in_use, stats.in_use);
+            return block;
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            const auto index = class_index(bytes);
+            if (!index.has_value() || alignment > alignof(std::max_align_t)) {
+                m_upstream->deallocate(p, bytes, alignment);
+                return;
+            }
+
+            auto& size_class = m_classes[index.value()];
+            const auto block = static_cast<FreeBlock*>(p);
+            block->next = size_class.free;
+            size_class.free = block;
+
+            ++size_class.stats.deallocations;
+            --size_class.stats.in_use;
+        }
+
+        [[nodiscard]]
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::size_t grow(std::size_t index) {
+            auto& size_class = m_classes[index];
+            const auto block_size = class_size(index);
+            const auto size = std::max(SLAB_SIZE, block_size * MIN_BLOCKS_PER_SLAB) + CACHE_LINE_SIZE;
+
+            const auto memory = static_cast<std::byte*>(m_upstream->allocate(size, CACHE_LINE_SIZE));
+            const auto slab = new (memory) Slab{size_class.slabs, size};
+            size_class.slabs = slab;
+            ++size_class.stats.slabs;
+
+            const auto count = (size - CACHE_LINE_SIZE) / block_size;
+            for (std::size_t i = count; i > 0; --i) {
+                const auto block = new (memory + CACHE_LINE_SIZE + (i - 1) * block_size) FreeBlock{size_class.free};
+                size_class.free = block;
+            }
+            return count;
+        }
+
+        std::pmr::memory_resource* m_upstream;
+        std::array<SizeClass, CLASSES> m_classes{};
+        std::size_t m_oversized{};
+    };
+}
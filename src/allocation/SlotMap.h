@@ -0,0 +1,242 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <span>
+#include <utility>
+
+namespace conq::memory {
+    /**
+     * 32-bit reference into a SlotMap: the low INDEX_BITS address the slot,
+     * the remaining bits carry the generation the slot had at insertion.
+     */
+    template<std::size_t INDEX_BITS>
+    requires (INDEX_BITS > 0 && INDEX_BITS < 32)
+    class Handle final {
+    public:
+        static constexpr std::uint32_t INDEX_MASK = (1U << INDEX_BITS) - 1;
+        static constexpr std::uint32_t GENERATION_MASK = ~INDEX_MASK >> INDEX_BITS;
+
+        constexpr Handle() = default;
+        constexpr Handle(std::uint32_t index, std::uint32_t generation) noexcept:
+                m_value((generation << INDEX_BITS) | (index & INDEX_MASK)) {}
+
+        [[nodiscard]]
+        constexpr std::uint32_t index() const noexcept {
+            return m_value & INDEX_MASK;
+        }
+
+        [[nodiscard]]
+        constexpr std::uint32_t generation() const noexcept {
+            return m_value >> INDEX_BITS;
+        }
+
+        [[nodiscard]]
+        constexpr std::uint32_t raw() const noexcept {
+            return m_value;
+        }
+
+        [[nodiscard]]
+        constexpr bool is_null() const noexcept {
+            return generation() == 0;
+        }
+
+        constexpr bool operator==(const Handle&) const noexcept = default;
+
+        static constexpr Handle from_raw(std::uint32_t raw) noexcept {
+            Handle h;
+            h.m_value = raw;
+            return h;
+        }
+
+    private:
+        std::uint32_t m_value{};
+    };
+
+    /**
+     * Fixed-capacity slot map. Values are kept densely packed (erase moves the last
+     * value into the hole) so iteration walks contiguous memory; handles stay valid
+     * until their own element is erased and go stale afterwards.
+     */
+    template<typename T, std::size_t N>
+    requires (N > 0 && N < (std::size_t{1} << 24))
+    class SlotMap final {
+        static constexpr std::size_t INDEX_BITS = std::bit_width(N);
+        static constexpr std::uint32_t END = N;
+
+    public:
+        using Handle = memory::Handle<INDEX_BITS>;
+
+        SlotMap() noexcept {
+            for (std::uint32_t i = 0; i < N; ++i) {
+                m_slots[i] = Entry{i + 1, 1};
+            }
+        }
+
+        SlotMap(const SlotMap&) = delete;
+        SlotMap& operator=(const SlotMap&) = delete;
+        SlotMap(SlotMap&&) = delete;
+        SlotMap& operator=(SlotMap&&) = delete;
+
+        ~SlotMap() {
+            clear();
+        }
+
+    public:
+        template <typename... Args>
+        [[nodiscard]]
+        std::optional<Handle> insert(Args&&... args) {
+            if (m_free == END) {
+                return std::nullopt;
+            }
+
+            const auto index = m_free;
+            auto& slot = m_slots[index];
+            new (data() + m_size) T(std::forward<Args>(args)...);
+
+            m_free = slot.link;
+            slot.link = static_cast<std::uint32_t>(m_size);
+            m_dense_to_slot[m_size] = index;
+            ++m_size;
+            return Handle(index, slot.generation);
+        }
+
+        [[nodiscard]]
+        T* get(Handle handle) noexcept {
+            const auto dense = find(handle);
+            return dense == END ? nullptr : data() + dense;
+        }
+
+        [[nodiscard]]
+        const T* get(Handle handle) const noexcept {
+            const auto dense = find(handle);
+            return dense == END ? nullptr : data() + dense;
+        }
+
+        [[nodiscard]]
+        bool contains(Handle handle) const noexcept {
+            return find(handle) != END;
+        }
+
+        bool erase(Handle handle) noexcept {
+            const auto dense = find(handle);
+            if (dense == END) {
+                return false;
+            }
+
+            const auto last = static_cast<std::uint32_t>(m_size - 1);
+            if (dense != last) {
+                data()[dense] = std::move(data()[last]);
+                const auto moved = m_dense_to_slot[last];
+                m_dense_to_slot[dense] = moved;
+                m_slots[moved].link = dense;
+            }
+            data()[last].~T();
+            --m_size;
+
+            auto& slot = m_slots[handle.index()];
+            slot.generation = next_generation(slot.generation);
+            slot.link = m_free;
+            m_free = handle.index();
+            return true;
+        }
+
+        void clear() noexcept {
+            while (m_size != 0) {
+                erase(handle_at(m_size - 1));
+            }
+        }
+
+        /**
+         * Handle of the element stored at the given dense position, so callers
+         * iterating values() can refer back to what they visit.
+         */
+        [[nodiscard]]
+        Handle handle_at(std::size_t dense) const noexcept {
+            const auto index = m_dense_to_slot[dense];
+            return Handle(index, m_slots[index].generation);
+        }
+
+        [[nodiscard]]
+        std::span<T> values() noexcept {
+            return {data(), m_size};
+        }
+
+        [[nodiscard]]
+        std::span<const T> values() const noexcept {
+            return {data(), m_size};
+        }
+
+        T* begin() noexcept {
+            return data();
+        }
+
+        T* end() noexcept {
+            return data() + m_size;
+        }
+
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        [[nodiscard]]
+        bool empty() const noexcept {
+            return m_size == 0;
+        }
+
+        [[nodiscard]]
+        bool is_full() const noexcept {
+            return m_size == N;
+        }
+
+        static constexpr std::size_t capacity() noexcept {
+            return N;
+        }
+
+    private:
+        struct Entry {
+            // Dense position while the slot is occupied, next free slot otherwise.
+            std::uint32_t link;
+            std::uint32_t generation;
+        };
+
+        [[nodiscard]]
+        std::uint32_t find(Handle handle) const noexcept {
+            const auto index = handle.index();
+            if (handle.is_null() || index >= N) {
+                return END;
+            }
+
+            const auto& slot = m_slots[index];
+            if (slot.generation != handle.generation() || slot.link >= m_size) {
+                return END;
+            }
+
+            return slot.link;
+        }
+
+        static constexpr std::uint32_t next_generation(std::uint32_t generation) noexcept {
+            const auto next = (generation + 1) & Handle::GENERATION_MASK;
+            return next == 0 ? 1 : next;
+        }
+
+        T* data() noexcept {
+            return std::launder(reinterpret_cast<T*>(m_values));
+        }
+
+        const T* data() const noexcept {
+            return std::launder(reinterpret_cast<const T*>(m_values));
+        }
+
+        alignas(T) std::byte m_values[sizeof(T) * N];
+        std::array<std::uint32_t, N> m_dense_to_slot{};
+        std::array<Entry, N> m_slots{};
+        std::size_t m_size{};
+        std::uint32_t m_free{};
+    };
+}
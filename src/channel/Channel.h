@@ -1,8 +1,11 @@
 #pragma once
 
+#include <filesystem>
 #include <ranges>
+#include <utility>
 #include "SPSCBoundedQueue.h"
 #include "Encoder.h"
+#include "os/ShMem.h"
 
 namespace conq {
     template<std::size_t N>
@@ -21,10 +24,14 @@ namespace conq {
             return write(std::span{data, size});
         }
 
+        /**
+         * Returns the number of bytes queued. When the ring fills up mid-message the rest
+         * can be sent by writing the remaining suffix again; it continues the same record.
+         */
         std::size_t write(std::span<const char> data) {
-            std::size_t written{};
             Encoder coder(data);
             while (true) {
+                const auto written = coder.position();
                 const auto encoded = coder.encode_bucket();
                 if (!encoded.has_value()) {
                     return written;
@@ -34,8 +41,6 @@ namespace conq {
                 if (!m_queue.try_push(val)) {
                     return written;
                 }
-
-                written++;
             }
         }
 
@@ -56,7 +61,17 @@ namespace conq {
         Reader& operator=(const Reader&) = delete;
 
         std::size_t read(const std::span<char> data) {
+            bool complete{};
+            return read(data, complete);
+        }
+
+        /**
+         * Like read(data), and sets 'complete' when the bytes read end a record (the
+         * span passed to one Writer::write call).
+         */
+        std::size_t read(const std::span<char> data, bool& complete) {
             std::size_t read{};
+            complete = false;
             while (read < data.size()) {
                 if (acquire_value()) {
                     return read;
@@ -72,6 +87,7 @@ namespace conq {
                 read += decoded.get_length();
                 m_cached = EMPTY;
                 if (decoded.is_last_record()) {
+                    complete = true;
                     return read;
                 }
             }
@@ -171,6 +187,10 @@ namespace conq {
             return m_reader->read(data, size);
         }
 
+        std::size_t read(std::span<char> data, bool& complete) {
+            return m_reader->read(data, complete);
+        }
+
     public:
         static std::optional<ChannelReader> open(const std::filesystem::path& path) {
             auto shmem = ShMem::open(path);
@@ -20,7 +20,7 @@ namespace conq {
 
         std::optional<std::size_t> encode_bucket() {
             std::size_t encoded{};
-            if (m_cursor + 1 >= m_data.size()) {
+            if (m_cursor >= m_data.size()) {
                 return std::nullopt;
             }
 
@@ -89,10 +89,19 @@ namespace conq {
             return encoded;
         }
 
+        /**
+         * Number of bytes already encoded into buckets.
+         */
+        [[nodiscard]]
+        std::size_t position() const {
+            return m_cursor;
+        }
+
     private:
         [[nodiscard]]
         std::size_t at(const std::size_t index) const {
-            return static_cast<std::size_t>(m_data[index]);
+            // Through unsigned char, so bytes >= 0x80 do not sign-extend over their neighbours.
+            return static_cast<unsigned char>(m_data[index]);
         }
 
         std::span<const char> m_data;
@@ -126,7 +135,7 @@ namespace conq {
         [[nodiscard]]
         std::optional<Record> decode_bucket(std::span<char> buffer) const {
             const auto length = get_length();
-            if (length > buffer.size()) {
+            if (static_cast<std::size_t>(length) > buffer.size()) {
                 return std::nullopt;
             }
 
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "channel/Channel.h"
+#include "metrics/Histogram.h"
+#include "os/Tsc.h"
+
+namespace conq {
+    /**
+     * ChannelWriter that precedes every message with an 8-byte TSC stamp, sent as a
+     * record of its own, for TimedChannelReader to measure how long messages wait in
+     * the channel.
+     *
+     * write() follows ChannelWriter: it returns the payload bytes queued, and a message
+     * that did not fit is finished by writing the remaining suffix. Empty messages
+     * cannot be sent.
+     */
+    template<std::size_t N>
+    requires PowerOfTwo<N>
+    class TimedChannelWriter final {
+    public:
+        explicit TimedChannelWriter(ChannelWriter<N>&& writer) :
+                m_writer(std::move(writer)) {
+            (void) Tsc::calibration();
+        }
+
+    public:
+        std::size_t write(std::span<const char> data) {
+            if (data.empty()) {
+                return 0;
+            }
+
+            if (m_remaining == 0) {
+                const auto stamp = Tsc::now();
+                std::memcpy(m_header.data(), &stamp, sizeof(stamp));
+                m_header_sent = 0;
+                m_remaining = data.size();
+            }
+            assert(data.size() == m_remaining && "resume a partial write with its remaining suffix");
+
+            if (m_header_sent < m_header.size()) {
+                m_header_sent += m_writer.write(std::span<const char>(m_header).subspan(m_header_sent));
+                if (m_header_sent < m_header.size()) {
+                    return 0;
+                }
+            }
+
+            const auto written = m_writer.write(data);
+            m_remaining -= written;
+            return written;
+        }
+
+        std::size_t write(const char *data, std::size_t size) {
+            return write(std::span{data, size});
+        }
+
+    public:
+        static std::optional<TimedChannelWriter> create(const std::filesystem::path& path) {
+            auto writer = ChannelWriter<N>::create(path);
+            if (!writer.has_value()) {
+                return std::nullopt;
+            }
+
+            return std::make_optional<TimedChannelWriter>(std::move(writer.value()));
+        }
+
+    private:
+        ChannelWriter<N> m_writer;
+        std::array<char, sizeof(std::uint64_t)> m_header{};
+        std::size_t m_header_sent{};
+        std::size_t m_remaining{};
+    };
+
+    /**
+     * Reading side of TimedChannelWriter. When a message's stamp is consumed, its
+     * residence time in ns goes into 'residence', which may live in a
+     * metrics::Registry so another process can scrape it.
+     */
+    template<std::size_t N>
+    requires PowerOfTwo<N>
+    class TimedChannelReader final {
+    public:
+        TimedChannelReader(ChannelReader<N>&& reader, metrics::Histogram& residence) :
+                m_reader(std::move(reader)),
+                m_residence(&residence) {
+            (void) Tsc::calibration();
+        }
+
+    public:
+        std::size_t read(std::span<char> data, bool& complete) {
+            complete = false;
+            if (m_header_read < m_header.size()) {
+                bool header_complete{};
+                m_header_read += m_reader.read(std::span<char>(m_header).subspan(m_header_read), header_complete);
+                if (m_header_read < m_header.size()) {
+                    return 0;
+                }
+
+                assert(header_complete && "channel is not written by a TimedChannelWriter");
+                std::uint64_t stamp{};
+                std::memcpy(&stamp, m_header.data(), sizeof(stamp));
+                m_residence->record(Tsc::calibration().since(stamp));
+            }
+
+            const auto read = m_reader.read(data, complete);
+            if (complete) {
+                m_header_read = 0;
+            }
+            return read;
+        }
+
+        std::size_t read(std::span<char> data) {
+            bool complete{};
+            return read(data, complete);
+        }
+
+        std::size_t read(char *data, std::size_t size) {
+            return read(std::span{data, size});
+        }
+
+    public:
+        static std::optional<TimedChannelReader> open(const std::filesystem::path& path, metrics::Histogram& residence) {
+            auto reader = ChannelReader<N>::open(path);
+            if (!reader.has_value()) {
+                return std::nullopt;
+            }
+
+            return std::make_optional<TimedChannelReader>(std::move(reader.value()), residence);
+        }
+
+    private:
+        ChannelReader<N> m_reader;
+        metrics::Histogram* m_residence;
+        std::array<char, sizeof(std::uint64_t)> m_header{};
+        std::size_t m_header_read{};
+    };
+}
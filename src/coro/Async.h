@@ -0,0 +1,136 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "channel/Channel.h"
+#include "coro/EventLoop.h"
+#include "os/EventFd.h"
+
+namespace conq {
+    /**
+     * co_await front end for any of the bounded queues (anything with try_push and
+     * try_pop). Producers on any thread push through it, which notifies the EventFd
+     * only while a consumer is parked; consumers on the loop thread co_await pop().
+     * Attach it with EventLoop::watch() before the first pop().
+     */
+    template<typename Queue>
+    class AsyncQueue final : public Source {
+    public:
+        using Value = decltype(std::declval<Queue&>().try_pop())::value_type;
+
+        AsyncQueue(Queue& queue, EventFd& event) noexcept :
+                Source(event),
+                m_queue(&queue) {}
+
+    public:
+        template<typename U>
+        bool try_push(U&& value) {
+            if (!m_queue->try_push(std::forward<U>(value))) {
+                return false;
+            }
+
+            notify();
+            return true;
+        }
+
+        /**
+         * Awaitable yielding the next element; suspends while the queue is empty.
+         */
+        [[nodiscard]]
+        auto pop() noexcept {
+            return PopAwaiter{this};
+        }
+
+    private:
+        struct PopAwaiter final : Waiter {
+            explicit PopAwaiter(AsyncQueue* owner) noexcept :
+                    owner(owner) {}
+
+            bool try_complete() override {
+                value = owner->m_queue->try_pop();
+                return value.has_value();
+            }
+
+            bool await_ready() {
+                return try_complete();
+            }
+
+            bool await_suspend(std::coroutine_handle<> awaiting) {
+                handle = awaiting;
+                return owner->park(*this);
+            }
+
+            Value await_resume() {
+                return std::move(value.value());
+            }
+
+            AsyncQueue* owner;
+            std::optional<Value> value{};
+        };
+
+        Queue* m_queue;
+    };
+
+    struct Received final {
+        std::size_t size{};
+        /** The bytes end a record (one write() on the other side). */
+        bool complete{};
+    };
+
+    /**
+     * co_await front end for a ChannelReader. The writer, possibly in another process
+     * sharing the EventFd through fork(), calls notify() on it after each write.
+     */
+    template<std::size_t N>
+    requires PowerOfTwo<N>
+    class AsyncChannelReader final : public Source {
+    public:
+        AsyncChannelReader(ChannelReader<N>& reader, EventFd& event) noexcept :
+                Source(event),
+                m_reader(&reader) {}
+
+    public:
+        /**
+         * Awaitable reading into 'data'; suspends until at least one byte arrives.
+         */
+        [[nodiscard]]
+        auto receive(std::span<char> data) noexcept {
+            return ReceiveAwaiter{this, data};
+        }
+
+    private:
+        struct ReceiveAwaiter final : Waiter {
+            ReceiveAwaiter(AsyncChannelReader* owner, std::span<char> data) noexcept :
+                    owner(owner),
+                    data(data) {}
+
+            bool try_complete() override {
+                received.size = owner->m_reader->read(data, received.complete);
+                return received.size != 0;
+            }
+
+            bool await_ready() {
+                return try_complete();
+            }
+
+            bool await_suspend(std::coroutine_handle<> awaiting) {
+                handle = awaiting;
+                return owner->park(*this);
+            }
+
+            Received await_resume() const noexcept {
+                return received;
+            }
+
+            AsyncChannelReader* owner;
+            std::span<char> data;
+            Received received{};
+        };
+
+        ChannelReader<N>* m_reader;
+    };
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <expected>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "os/EventFd.h"
+#include "os/LinuxError.h"
+
+namespace conq {
+    /**
+     * Fire-and-forget coroutine run by an EventLoop. It starts suspended; spawn() hands
+     * it to the loop, which destroys it when it finishes. An exception escaping the
+     * coroutine terminates the program.
+     */
+    class Task final {
+    public:
+        struct promise_type {
+            Task get_return_object() noexcept {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept {
+                return {};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept {
+                std::terminate();
+            }
+        };
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        Task(Task&& other) noexcept :
+                m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+        ~Task() {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+        }
+
+    private:
+        friend class EventLoop;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) noexcept :
+                m_handle(handle) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    class EventLoop;
+
+    /**
+     * A suspended co_await on some Source. try_complete() attempts the operation
+     * without blocking and stores its result in the awaiter.
+     */
+    class Waiter {
+    public:
+        virtual bool try_complete() = 0;
+
+        std::coroutine_handle<> handle{};
+
+    protected:
+        ~Waiter() = default;
+    };
+
+    /**
+     * Something coroutines wait on, woken through an EventFd. Adapters such as
+     * AsyncQueue derive from it; EventLoop::watch() attaches one to a loop, which must
+     * outlive it.
+     */
+    class Source {
+    public:
+        explicit Source(EventFd& event) noexcept :
+                m_event(&event) {}
+
+        Source(const Source&) = delete;
+        Source& operator=(const Source&) = delete;
+
+    protected:
+        inline ~Source();
+
+        /**
+         * Completes 'waiter' at once if possible; otherwise parks it until the EventFd
+         * fires. Returns true if the caller must suspend.
+         */
+        bool park(Waiter& waiter) {
+            m_event->arm();
+            if (waiter.try_complete()) {
+                return false;
+            }
+            m_waiters.push_back(&waiter);
+            return true;
+        }
+
+        /**
+         * Producer side, any thread: call after publishing data. Wakes the loop only
+         * while a waiter is parked.
+         */
+        void notify() noexcept {
+            m_event->notify();
+        }
+
+    private:
+        friend class EventLoop;
+
+        inline void on_event();
+        inline void complete_waiters();
+
+        EventFd* m_event;
+        EventLoop* m_loop{};
+        std::deque<Waiter*> m_waiters{};
+    };
+
+    /**
+     * Single-threaded scheduler: runs spawned Tasks until all have finished, sleeping
+     * in epoll_wait while every task is parked on a Source. Nothing spins; a parked
+     * consumer costs no CPU until its producer calls EventFd::notify().
+     *
+     * All Tasks, awaits and watch() calls belong to the thread that calls run().
+     * Do not move the loop after watch().
+     */
+    class EventLoop final {
+    private:
+        explicit EventLoop(int epoll) noexcept :
+                m_epoll(epoll) {}
+
+    public:
+        EventLoop(const EventLoop&) = delete;
+        EventLoop& operator=(const EventLoop&) = delete;
+
+        EventLoop(EventLoop&& other) noexcept :
+                m_epoll(std::exchange(other.m_epoll, EMPTY_FD)),
+                m_ready(std::move(other.m_ready)),
+                m_tasks(std::move(other.m_tasks)),
+                m_live(std::exchange(other.m_live, 0)) {}
+
+        /**
+         * Destroys tasks that are still suspended.
+         */
+        ~EventLoop() {
+            for (const auto handle: m_tasks) {
+                handle.destroy();
+            }
+            if (m_epoll != EMPTY_FD) {
+                close(m_epoll);
+            }
+        }
+
+    public:
+        void spawn(Task task) {
+            const auto handle = std::exchange(task.m_handle, nullptr);
+            m_tasks.push_back(handle);
+            ++m_live;
+            schedule(handle);
+        }
+
+        void schedule(std::coroutine_handle<> handle) {
+            m_ready.push_back(handle);
+        }
+
+        /**
+         * Starts polling 'source'. The loop must outlive it.
+         */
+        [[nodiscard]]
+        std::optional<LinuxError> watch(Source& source) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.ptr = &source;
+            if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, source.m_event->fd(), &event) == -1) {
+                return LinuxError(errno);
+            }
+
+            source.m_loop = this;
+            return std::nullopt;
+        }
+
+        void unwatch(Source& source) noexcept {
+            epoll_ctl(m_epoll, EPOLL_CTL_DEL, source.m_event->fd(), nullptr);
+            source.m_loop = nullptr;
+        }
+
+        /**
+         * Runs until every spawned Task has finished.
+         */
+        [[nodiscard]]
+        std::optional<LinuxError> run() {
+            while (m_live != 0) {
+                // One batch at a time, so that tasks which keep yielding do not starve
+                // the parked ones of their events.
+                auto batch = m_ready.size();
+                while (batch-- != 0) {
+                    const auto handle = m_ready.front();
+                    m_ready.pop_front();
+                    handle.resume();
+                    if (handle.done()) {
+                        finish(handle);
+                    }
+                }
+
+                if (m_live != 0) {
+                    if (auto err = poll(m_ready.empty() ? -1 : 0); err.has_value()) {
+                        return err;
+                    }
+                }
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * co_await loop.yield() lets the other ready tasks run first.
+         */
+        [[nodiscard]]
+        auto yield() noexcept {
+            struct Yield {
+                EventLoop* loop;
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> handle) const {
+                    loop->schedule(handle);
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return Yield{this};
+        }
+
+        [[nodiscard]]
+        std::size_t live() const noexcept {
+            return m_live;
+        }
+
+    public:
+        static std::expected<EventLoop, LinuxError> create() {
+            const auto epoll = epoll_create1(EPOLL_CLOEXEC);
+            if (epoll == -1) {
+                return LinuxError::errno_v();
+            }
+            return EventLoop(epoll);
+        }
+
+    private:
+        std::optional<LinuxError> poll(int timeout) {
+            std::array<epoll_event, MAX_EVENTS> events{};
+            const auto count = epoll_wait(m_epoll, events.data(), MAX_EVENTS, timeout);
+            if (count == -1) {
+                return errno == EINTR ? std::nullopt : std::optional(LinuxError(errno));
+            }
+
+            for (int i = 0; i < count; ++i) {
+                static_cast<Source*>(events[i].data.ptr)->on_event();
+            }
+            return std::nullopt;
+        }
+
+        void finish(std::coroutine_handle<> handle) {
+            for (auto& task: m_tasks) {
+                if (task.address() == handle.address()) {
+                    task.destroy();
+                    task = m_tasks.back();
+                    m_tasks.pop_back();
+                    --m_live;
+                    return;
+                }
+            }
+        }
+
+        static constexpr int EMPTY_FD = -1;
+        static constexpr int MAX_EVENTS = 64;
+
+        int m_epoll;
+        std::deque<std::coroutine_handle<>> m_ready{};
+        std::vector<std::coroutine_handle<Task::promise_type>> m_tasks{};
+        std::size_t m_live{};
+    };
+
+    Source::~Source() {
+        if (m_loop != nullptr) {
+            m_loop->unwatch(*this);
+        }
+    }
+
+    void Source::on_event() {
+        m_event->drain();
+        m_event->disarm();
+        complete_waiters();
+        if (!m_waiters.empty()) {
+            // Data published between disarm() and arm() did not notify; look again.
+            m_event->arm();
+            complete_waiters();
+        }
+    }
+
+    void Source::complete_waiters() {
+        auto waiting = m_waiters.size();
+        while (waiting-- != 0) {
+            const auto waiter = m_waiters.front();
+            m_waiters.pop_front();
+            if (waiter->try_complete()) {
+                m_loop->schedule(waiter->handle);
+            } else {
+                m_waiters.push_back(waiter);
+            }
+        }
+    }
+}
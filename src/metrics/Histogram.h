@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "Definitions.h"
+
+namespace conq::metrics {
+    /**
+     * Log-linear bucket layout in the spirit of HdrHistogram: values below SUB_BUCKETS
+     * are exact, and every power of two above is split into SUB_BUCKETS / 2 linear
+     * buckets, so the relative error stays below 2 / SUB_BUCKETS over the whole 64-bit
+     * range.
+     */
+    struct LogLinear final {
+        static constexpr std::size_t SUB_BUCKET_BITS = 7;
+        static constexpr std::size_t SUB_BUCKETS = std::size_t{1} << SUB_BUCKET_BITS;
+        static constexpr std::size_t HALF = SUB_BUCKETS / 2;
+        static constexpr std::size_t BUCKETS = (64 - SUB_BUCKET_BITS + 2) * HALF;
+
+        static constexpr std::size_t index_of(std::uint64_t value) noexcept {
+            if (value < SUB_BUCKETS) {
+                return static_cast<std::size_t>(value);
+            }
+
+            // value >> magnitude lies in [HALF, SUB_BUCKETS), so octaves tile the index space.
+            const auto magnitude = static_cast<std::size_t>(std::bit_width(value)) - SUB_BUCKET_BITS;
+            return magnitude * HALF + static_cast<std::size_t>(value >> magnitude);
+        }
+
+        static constexpr std::uint64_t highest_equivalent(std::size_t index) noexcept {
+            if (index < SUB_BUCKETS) {
+                return index;
+            }
+
+            const auto magnitude = index / HALF - 1;
+            const auto sub = static_cast<std::uint64_t>(index - magnitude * HALF);
+            return (sub << magnitude) + (std::uint64_t{1} << magnitude) - 1;
+        }
+    };
+
+    static_assert(LogLinear::index_of(UINT64_MAX) == LogLinear::BUCKETS - 1);
+    static_assert(LogLinear::highest_equivalent(LogLinear::BUCKETS - 1) == UINT64_MAX);
+
+    /**
+     * Plain (single-threaded) histogram: the result of Histogram::snapshot, and a cheap
+     * recorder for code that keeps one histogram per thread and merges at the end.
+     */
+    class HistogramSnapshot final {
+    public:
+        HistogramSnapshot() = default;
+
+        void record(std::uint64_t value) noexcept {
+            ++m_counts[LogLinear::index_of(value)];
+            ++m_total;
+            m_sum += value;
+            m_max = std::max(m_max, value);
+            m_min = std::min(m_min, value);
+        }
+
+        void merge(const HistogramSnapshot& other) noexcept {
+            for (std::size_t i = 0; i < LogLinear::BUCKETS; ++i) {
+                m_counts[i] += other.m_counts[i];
+            }
+            m_total += other.m_total;
+            m_sum += other.m_sum;
+            m_max = std::max(m_max, other.m_max);
+            m_min = std::min(m_min, other.m_min);
+        }
+
+        /**
+         * Highest value of the bucket at or below which 'quantile' of all values lie.
+         */
+        [[nodiscard]]
+        std::uint64_t percentile(double quantile) const noexcept {
+            if (m_total == 0) {
+                return 0;
+            }
+
+            const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(quantile * static_cast<double>(m_total) + 0.5));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < LogLinear::BUCKETS; ++i) {
+                seen += m_counts[i];
+                if (seen >= rank) {
+                    return std::min(LogLinear::highest_equivalent(i), m_max);
+                }
+            }
+            return m_max;
+        }
+
+        [[nodiscard]]
+        std::uint64_t count() const noexcept {
+            return m_total;
+        }
+
+        [[nodiscard]]
+        std::uint64_t max() const noexcept {
+            return m_max;
+        }
+
+        [[nodiscard]]
+        std::uint64_t min() const noexcept {
+            return m_total == 0 ? 0 : m_min;
+        }
+
+        [[nodiscard]]
+        double mean() const noexcept {
+            return m_total == 0 ? 0.0 : static_cast<double>(m_sum) / static_cast<double>(m_total);
+        }
+
+    private:
+        friend class Histogram;
+
+        std::array<std::uint64_t, LogLinear::BUCKETS> m_counts{};
+        std::uint64_t m_total{};
+        std::uint64_t m_sum{};
+        std::uint64_t m_max{};
+        std::uint64_t m_min{UINT64_MAX};
+    };
+
+    /**
+     * Fixed-size, lock-free histogram any number of threads can record into. It holds no
+     * pointers, so it can be placed in a ShMem segment and snapshotted by another process
+     * while writers keep recording; the snapshot is not atomic as a whole, but every
+     * bucket is, and count() of the snapshot always matches its buckets.
+     */
+    class alignas (CACHE_LINE_SIZE) Histogram final {
+    public:
+        Histogram() = default;
+
+        Histogram(const Histogram&) = delete;
+        Histogram& operator=(const Histogram&) = delete;
+
+    public:
+        void record(std::uint64_t value) noexcept {
+            m_counts[LogLinear::index_of(value)].fetch_add(1, std::memory_order_relaxed);
+            m_sum.fetch_add(value, std::memory_order_relaxed);
+
+            auto max = m_max.load(std::memory_order_relaxed);
+            while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+            auto min = m_min.load(std::memory_order_relaxed);
+            while (value < min && !m_min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {}
+        }
+
+        [[nodiscard]]
+        HistogramSnapshot snapshot() const noexcept {
+            HistogramSnapshot result{};
+            for (std::size_t i = 0; i < LogLinear::BUCKETS; ++i) {
+                const auto count = m_counts[i].load(std::memory_order_relaxed);
+                result.m_counts[i] = count;
+                result.m_total += count;
+            }
+            result.m_sum = m_sum.load(std::memory_order_relaxed);
+            result.m_max = m_max.load(std::memory_order_relaxed);
+            result.m_min = m_min.load(std::memory_order_relaxed);
+            return result;
+        }
+
+        /**
+         * Not atomic with respect to concurrent record calls; values recorded meanwhile may
+         * survive partially.
+         */
+        void reset() noexcept {
+            for (auto& count: m_counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+            m_sum.store(0, std::memory_order_relaxed);
+            m_max.store(0, std::memory_order_relaxed);
+            m_min.store(UINT64_MAX, std::memory_order_relaxed);
+        }
+
+    private:
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+        std::array<std::atomic<std::uint64_t>, LogLinear::BUCKETS> m_counts{};
+        std::atomic<std::uint64_t> m_sum{};
+        std::atomic<std::uint64_t> m_max{};
+        std::atomic<std::uint64_t> m_min{UINT64_MAX};
+    };
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+#include "Definitions.h"
+#include "metrics/Histogram.h"
+
+namespace conq::metrics {
+    class alignas (CACHE_LINE_SIZE) Counter final {
+    public:
+        Counter() = default;
+
+        Counter(const Counter&) = delete;
+        Counter& operator=(const Counter&) = delete;
+
+    public:
+        void add(std::uint64_t n = 1) noexcept {
+            m_value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        std::uint64_t value() const noexcept {
+            return m_value.load(std::memory_order_relaxed);
+        }
+
+        void reset() noexcept {
+            m_value.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::uint64_t> m_value{};
+    };
+
+    class alignas (CACHE_LINE_SIZE) Gauge final {
+    public:
+        Gauge() = default;
+
+        Gauge(const Gauge&) = delete;
+        Gauge& operator=(const Gauge&) = delete;
+
+    public:
+        void set(std::int64_t value) noexcept {
+            m_value.store(value, std::memory_order_relaxed);
+        }
+
+        void add(std::int64_t delta) noexcept {
+            m_value.fetch_add(delta, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        std::int64_t value() const noexcept {
+            return m_value.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::int64_t> m_value{};
+    };
+
+    /**
+     * Fixed-capacity set of named counters, gauges and histograms. Everything lives inline
+     * and holds no pointers, so a registry can be created in a ShMem segment by the
+     * process that records and opened by a scraper that only reads.
+     *
+     * Registration takes a short spin lock (it is expected once per metric, at setup);
+     * updating a metric through the returned pointer is lock-free. Entries are published
+     * in order, so a reader walking [0, size) never sees a half-written name.
+     */
+    template<std::size_t COUNTERS = 64, std::size_t GAUGES = 64, std::size_t HISTOGRAMS = 16>
+    class Registry final {
+    public:
+        static constexpr std::size_t MAX_NAME = 47;
+
+        Registry() = default;
+
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+    public:
+        /**
+         * Returns the counter named 'name', creating it on first use; nullptr when the
+         * name is longer than MAX_NAME or the registry is full.
+         */
+        [[nodiscard]]
+        Counter* counter(std::string_view name) noexcept {
+            return find_or_add(m_counters, name);
+        }
+
+        [[nodiscard]]
+        Gauge* gauge(std::string_view name) noexcept {
+            return find_or_add(m_gauges, name);
+        }
+
+        [[nodiscard]]
+        Histogram* histogram(std::string_view name) noexcept {
+            return find_or_add(m_histograms, name);
+        }
+
+        /**
+         * Calls 'visitor(name, metric)' for every registered metric, where metric is a
+         * const Counter&, Gauge& or Histogram&.
+         */
+        template<typename Visitor>
+        void visit(Visitor&& visitor) const {
+            visit_table(m_counters, visitor);
+            visit_table(m_gauges, visitor);
+            visit_table(m_histograms, visitor);
+        }
+
+    private:
+        template<typename M>
+        struct Entry final {
+            std::array<char, MAX_NAME + 1> name{};
+            M metric{};
+
+            [[nodiscard]]
+            std::string_view view() const noexcept {
+                return {name.data()};
+            }
+        };
+
+        template<typename M, std::size_t N>
+        struct Table final {
+            std::array<Entry<M>, N> entries{};
+            std::atomic<std::size_t> size{};
+        };
+
+        template<typename M, std::size_t N>
+        static M* find(Table<M, N>& table, std::string_view name) noexcept {
+            const auto size = table.size.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < size; ++i) {
+                if (table.entries[i].view() == name) {
+                    return &table.entries[i].metric;
+                }
+            }
+            return nullptr;
+        }
+
+        template<typename M, std::size_t N>
+        M* find_or_add(Table<M, N>& table, std::string_view name) noexcept {
+            if (name.size() > MAX_NAME) {
+                return nullptr;
+            }
+
+            const auto found = find(table, name);
+            if (found != nullptr) {
+                return found;
+            }
+
+            lock();
+            // Somebody may have registered the same name while we were waiting.
+            auto result = find(table, name);
+            const auto size = table.size.load(std::memory_order_relaxed);
+            if (result == nullptr && size < N) {
+                auto& entry = table.entries[size];
+                std::ranges::copy(name, entry.name.begin());
+                table.size.store(size + 1, std::memory_order_release);
+                result = &entry.metric;
+            }
+            unlock();
+            return result;
+        }
+
+        template<typename M, std::size_t N, typename Visitor>
+        static void visit_table(const Table<M, N>& table, Visitor& visitor) {
+            const auto size = table.size.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < size; ++i) {
+                visitor(table.entries[i].view(), static_cast<const M&>(table.entries[i].metric));
+            }
+        }
+
+        void lock() noexcept {
+            while (m_lock.exchange(true, std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+
+        void unlock() noexcept {
+            m_lock.store(false, std::memory_order_release);
+        }
+
+        static_assert(std::atomic<bool>::is_always_lock_free);
+        static_assert(std::atomic<std::size_t>::is_always_lock_free);
+
+        std::atomic<bool> m_lock{};
+        Table<Counter, COUNTERS> m_counters{};
+        Table<Gauge, GAUGES> m_gauges{};
+        Table<Histogram, HISTOGRAMS> m_histograms{};
+    };
+
+    /**
+     * One metric per line: "name value" for counters and gauges, and count, mean and
+     * percentiles for histograms.
+     */
+    template<std::size_t COUNTERS, std::size_t GAUGES, std::size_t HISTOGRAMS>
+    std::ostream& operator<<(std::ostream& os, const Registry<COUNTERS, GAUGES, HISTOGRAMS>& registry) {
+        struct Printer final {
+            std::ostream& os;
+
+            void operator()(std::string_view name, const Counter& counter) const {
+                os << name << ' ' << counter.value() << '\n';
+            }
+
+            void operator()(std::string_view name, const Gauge& gauge) const {
+                os << name << ' ' << gauge.value() << '\n';
+            }
+
+            void operator()(std::string_view name, const Histogram& histogram) const {
+                const auto snapshot = histogram.snapshot();
+                os << name
+                   << " count=" << snapshot.count()
+                   << " mean=" << snapshot.mean()
+                   << " p50=" << snapshot.percentile(0.50)
+                   << " p99=" << snapshot.percentile(0.99)
+                   << " p999=" << snapshot.percentile(0.999)
+                   << " max=" << snapshot.max() << '\n';
+            }
+        };
+
+        registry.visit(Printer{os});
+        return os;
+    }
+}
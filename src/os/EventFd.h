@@ -0,0 +1,107 @@
+#pragma once
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <expected>
+#include <new>
+#include <utility>
+
+#include "os/LinuxError.h"
+
+namespace conq {
+    /**
+     * Non-blocking eventfd that an EventLoop polls, plus an "armed" flag so that
+     * notify() only makes a syscall while a consumer is actually parked. The flag sits
+     * in a shared anonymous page, so after a fork both the descriptor and the flag are
+     * shared: a child can wake a loop in its parent (or the other way round), e.g. when
+     * it has written to a shared-memory channel.
+     */
+    class EventFd final {
+    private:
+        EventFd(int fd, std::atomic<std::uint32_t>* armed) :
+                m_fd(fd),
+                m_armed(armed) {}
+
+    public:
+        EventFd(const EventFd&) = delete;
+        EventFd& operator=(const EventFd&) = delete;
+
+        EventFd(EventFd&& other) noexcept :
+                m_fd(std::exchange(other.m_fd, EMPTY_FD)),
+                m_armed(std::exchange(other.m_armed, nullptr)) {}
+
+        ~EventFd() {
+            if (m_fd != EMPTY_FD) {
+                close(m_fd);
+            }
+            if (m_armed != nullptr) {
+                munmap(m_armed, sizeof(*m_armed));
+            }
+        }
+
+    public:
+        /**
+         * Producer side, any thread or process. Call after publishing data.
+         */
+        void notify() noexcept {
+            // Pairs with arm(): either the consumer's re-check sees the data or this
+            // sees the flag.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_armed->load(std::memory_order_relaxed) != 0) {
+                const std::uint64_t one = 1;
+                (void) write(m_fd, &one, sizeof(one));
+            }
+        }
+
+        /**
+         * Consumer side: announce a parked consumer. Re-check for data afterwards.
+         */
+        void arm() noexcept {
+            m_armed->store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        void disarm() noexcept {
+            m_armed->store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * Resets the counter; never blocks.
+         */
+        void drain() noexcept {
+            std::uint64_t count{};
+            (void) read(m_fd, &count, sizeof(count));
+        }
+
+        [[nodiscard]]
+        int fd() const noexcept {
+            return m_fd;
+        }
+
+    public:
+        static std::expected<EventFd, LinuxError> create() {
+            const auto fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (fd == -1) {
+                return LinuxError::errno_v();
+            }
+
+            const auto page = mmap(nullptr, sizeof(std::atomic<std::uint32_t>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (page == MAP_FAILED) {
+                const auto err = errno;
+                close(fd);
+                return LinuxError::unexpect(err);
+            }
+
+            return EventFd(fd, new(page) std::atomic<std::uint32_t>{0});
+        }
+
+    private:
+        static constexpr int EMPTY_FD = -1;
+        int m_fd;
+        std::atomic<std::uint32_t>* m_armed;
+    };
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+
+#include "Definitions.h"
+
+namespace conq {
+    namespace futex {
+        static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex word must be a plain 32-bit integer");
+
+        /**
+         * Absolute CLOCK_MONOTONIC time 'timeout' from now; negative timeouts mean now.
+         */
+        inline timespec deadline_after(std::chrono::nanoseconds timeout) noexcept {
+            constexpr long NS_PER_S = 1'000'000'000;
+            timespec now{};
+            clock_gettime(CLOCK_MONOTONIC, &now);
+
+            const auto ns = std::max<std::int64_t>(timeout.count(), 0);
+            const auto total = now.tv_nsec + ns % NS_PER_S;
+            return timespec{
+                    now.tv_sec + static_cast<time_t>(ns / NS_PER_S + total / NS_PER_S),
+                    static_cast<long>(total % NS_PER_S)};
+        }
+
+        /**
+         * Sleeps while 'word' holds 'expected', until woken or the absolute
+         * CLOCK_MONOTONIC 'deadline' (nullptr for none) passes. Returns 0 when woken,
+         * otherwise EAGAIN (the word had already changed), EINTR or ETIMEDOUT; callers
+         * re-check their condition in every case.
+         *
+         * Shared futexes (no FUTEX_PRIVATE_FLAG) are keyed by the physical page, so the
+         * word may live in a ShMem segment mapped at different addresses.
+         */
+        inline int wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, const timespec* deadline = nullptr) noexcept {
+            if (syscall(SYS_futex, &word, FUTEX_WAIT_BITSET, expected, deadline, nullptr, FUTEX_BITSET_MATCH_ANY) == -1) {
+                const auto err = errno;
+                assert((err == EAGAIN || err == EINTR || err == ETIMEDOUT) && "futex word misused");
+                return err;
+            }
+            return 0;
+        }
+
+        inline void wake(std::atomic<std::uint32_t>& word, int count) noexcept {
+            syscall(SYS_futex, &word, FUTEX_WAKE, count, nullptr, nullptr, 0);
+        }
+
+        /** Polls before a waiter goes to the kernel; a handoff within this window costs no syscall. */
+        constexpr int SPINS = 128;
+    }
+
+    /**
+     * Counting semaphore on a futex. It has no name and no file: construct it in a
+     * ShMem segment (or any shared mapping) next to the data it guards and every
+     * process mapping the segment can use it. post() makes a syscall only when some
+     * process is asleep on it.
+     */
+    class FutexSemaphore final {
+    public:
+        explicit FutexSemaphore(std::uint32_t initial = 0) :
+                m_count(initial) {}
+
+        FutexSemaphore(const FutexSemaphore&) = delete;
+        FutexSemaphore& operator=(const FutexSemaphore&) = delete;
+
+    public:
+        void post() noexcept {
+            // seq_cst pairs with the waiter's registration: either it sees the new count
+            // or this sees the waiter.
+            m_count.fetch_add(1, std::memory_order_seq_cst);
+            if (m_waiters.load(std::memory_order_seq_cst) != 0) {
+                futex::wake(m_count, 1);
+            }
+        }
+
+        [[nodiscard]]
+        bool try_wait() noexcept {
+            auto count = m_count.load(std::memory_order_relaxed);
+            while (count != 0) {
+                if (m_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void wait() noexcept {
+            (void) wait_until(nullptr);
+        }
+
+        /**
+         * Returns false if the count stayed zero for 'timeout'.
+         */
+        [[nodiscard]]
+        bool wait_for(std::chrono::nanoseconds timeout) noexcept {
+            const auto deadline = futex::deadline_after(timeout);
+            return wait_until(&deadline);
+        }
+
+        [[nodiscard]]
+        std::uint32_t value() const noexcept {
+            return m_count.load(std::memory_order_relaxed);
+        }
+
+    private:
+        bool wait_until(const timespec* deadline) noexcept {
+            for (int i = 0; i < futex::SPINS; ++i) {
+                if (try_wait()) {
+                    return true;
+                }
+                cpu_relax();
+            }
+
+            while (!try_wait()) {
+                m_waiters.fetch_add(1, std::memory_order_seq_cst);
+                const auto err = futex::wait(m_count, 0, deadline);
+                m_waiters.fetch_sub(1, std::memory_order_relaxed);
+                if (err == ETIMEDOUT) {
+                    return try_wait();
+                }
+            }
+            return true;
+        }
+
+        std::atomic<std::uint32_t> m_count;
+        std::atomic<std::uint32_t> m_waiters{};
+    };
+
+    /**
+     * Manual-reset event on a futex: set() releases every current and future waiter
+     * until reset(). Place it in shared memory like FutexSemaphore, e.g. to tell a
+     * reader process that a channel has been created.
+     */
+    class FutexEvent final {
+    public:
+        FutexEvent() = default;
+
+        FutexEvent(const FutexEvent&) = delete;
+        FutexEvent& operator=(const FutexEvent&) = delete;
+
+    public:
+        void set() noexcept {
+            m_state.store(SET, std::memory_order_seq_cst);
+            if (m_waiters.load(std::memory_order_seq_cst) != 0) {
+                futex::wake(m_state, INT_MAX);
+            }
+        }
+
+        void reset() noexcept {
+            m_state.store(CLEAR, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        bool try_wait() const noexcept {
+            return m_state.load(std::memory_order_acquire) == SET;
+        }
+
+        void wait() noexcept {
+            (void) wait_until(nullptr);
+        }
+
+        [[nodiscard]]
+        bool wait_for(std::chrono::nanoseconds timeout) noexcept {
+            const auto deadline = futex::deadline_after(timeout);
+            return wait_until(&deadline);
+        }
+
+    private:
+        bool wait_until(const timespec* deadline) noexcept {
+            for (int i = 0; i < futex::SPINS; ++i) {
+                if (try_wait()) {
+                    return true;
+                }
+                cpu_relax();
+            }
+
+            while (!try_wait()) {
+                m_waiters.fetch_add(1, std::memory_order_seq_cst);
+                const auto err = futex::wait(m_state, CLEAR, deadline);
+                m_waiters.fetch_sub(1, std::memory_order_relaxed);
+                if (err == ETIMEDOUT) {
+                    return try_wait();
+                }
+            }
+            return true;
+        }
+
+        static constexpr std::uint32_t CLEAR = 0;
+        static constexpr std::uint32_t SET = 1;
+        std::atomic<std::uint32_t> m_state{CLEAR};
+        std::atomic<std::uint32_t> m_waiters{};
+    };
+
+    /**
+     * Process-shared mutex on a futex (Drepper's three-state lock: unlocked, locked,
+     * locked with sleepers). unlock() makes a syscall only when someone sleeps. Meets
+     * Lockable, so std::lock_guard and std::unique_lock work. If the owner dies, the
+     * mutex stays locked.
+     */
+    class FutexMutex final {
+    public:
+        FutexMutex() = default;
+
+        FutexMutex(const FutexMutex&) = delete;
+        FutexMutex& operator=(const FutexMutex&) = delete;
+
+    public:
+        [[nodiscard]]
+        bool try_lock() noexcept {
+            auto state = UNLOCKED;
+            return m_state.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        void lock() noexcept {
+            (void) lock_until(nullptr);
+        }
+
+        /**
+         * Returns false if the mutex could not be taken within 'timeout'.
+         */
+        [[nodiscard]]
+        bool try_lock_for(std::chrono::nanoseconds timeout) noexcept {
+            const auto deadline = futex::deadline_after(timeout);
+            return lock_until(&deadline);
+        }
+
+        void unlock() noexcept {
+            if (m_state.fetch_sub(1, std::memory_order_release) != LOCKED) {
+                m_state.store(UNLOCKED, std::memory_order_release);
+                futex::wake(m_state, 1);
+            }
+        }
+
+    private:
+        bool lock_until(const timespec* deadline) noexcept {
+            for (int i = 0; i < futex::SPINS; ++i) {
+                if (try_lock()) {
+                    return true;
+                }
+                cpu_relax();
+            }
+
+            // Whoever takes the lock from here on marks it contended, so its unlock wakes
+            // the next sleeper.
+            auto state = m_state.exchange(CONTENDED, std::memory_order_acquire);
+            while (state != UNLOCKED) {
+                if (futex::wait(m_state, CONTENDED, deadline) == ETIMEDOUT) {
+                    return m_state.exchange(CONTENDED, std::memory_order_acquire) == UNLOCKED;
+                }
+                state = m_state.exchange(CONTENDED, std::memory_order_acquire);
+            }
+            return true;
+        }
+
+        static constexpr std::uint32_t UNLOCKED = 0;
+        static constexpr std::uint32_t LOCKED = 1;
+        static constexpr std::uint32_t CONTENDED = 2;
+        std::atomic<std::uint32_t> m_state{UNLOCKED};
+    };
+}
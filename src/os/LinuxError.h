@@ -10,6 +10,11 @@ namespace conq {
     public:
         explicit LinuxError(int error) : m_error(error) {}
 
+        [[nodiscard]]
+        int code() const noexcept {
+            return m_error;
+        }
+
         std::ostream& operator<<(std::ostream& os) const {
             return os << std::strerror(m_error);
         }
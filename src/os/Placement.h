@@ -0,0 +1,141 @@
+#pragma once
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <expected>
+#include <future>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "os/LinuxError.h"
+#include "os/Process.h"
+#include "os/Topology.h"
+
+namespace conq {
+    /**
+     * Where and how a thread or process runs: the CPUs it may use, an optional
+     * SCHED_FIFO priority, and whether its memory is bound to the NUMA node(s) of those
+     * CPUs. All three are per-thread in Linux, so apply() affects only the caller;
+     * threads and processes it creates afterwards inherit them.
+     */
+    struct Placement final {
+        /** Allowed CPUs; empty leaves the affinity unchanged. */
+        std::vector<int> cpus{};
+        /** SCHED_FIFO priority (1-99); needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance. */
+        std::optional<int> fifo_priority{};
+        /** Bind future allocations to the nodes of 'cpus' (MPOL_BIND). */
+        bool local_memory = false;
+
+        [[nodiscard]]
+        static Placement on(int cpu) {
+            return Placement{{cpu}};
+        }
+
+        [[nodiscard]]
+        std::optional<LinuxError> apply() const {
+            if (!cpus.empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                for (const auto cpu: cpus) {
+                    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                        return LinuxError(EINVAL);
+                    }
+                    CPU_SET(cpu, &set);
+                }
+                if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+                    return LinuxError(errno);
+                }
+            }
+
+            if (fifo_priority.has_value()) {
+                sched_param param{};
+                param.sched_priority = fifo_priority.value();
+                if (sched_setscheduler(0, SCHED_FIFO, &param) == -1) {
+                    return LinuxError(errno);
+                }
+            }
+
+            if (local_memory) {
+                return bind_memory();
+            }
+            return std::nullopt;
+        }
+
+    private:
+        static constexpr int MPOL_BIND_MODE = 2;
+
+        [[nodiscard]]
+        std::optional<LinuxError> bind_memory() const {
+            if (cpus.empty()) {
+                return LinuxError(EINVAL);
+            }
+
+            const auto topology = Topology::query();
+            if (!topology.has_value()) {
+                return topology.error();
+            }
+
+            constexpr std::size_t BITS = 8 * sizeof(unsigned long);
+            std::vector<unsigned long> mask(1);
+            for (const auto id: cpus) {
+                const auto cpu = topology->cpu(id);
+                if (cpu == nullptr) {
+                    return LinuxError(EINVAL);
+                }
+
+                const auto node = static_cast<std::size_t>(cpu->node);
+                mask.resize(std::max(mask.size(), node / BITS + 1));
+                mask[node / BITS] |= 1ul << (node % BITS);
+            }
+
+            // The kernel reads maxnode - 1 bits.
+            const auto max_node = mask.size() * BITS + 1;
+            if (syscall(SYS_set_mempolicy, MPOL_BIND_MODE, mask.data(), max_node) == -1) {
+                return LinuxError(errno);
+            }
+            return std::nullopt;
+        }
+    };
+
+    /**
+     * Starts a thread that applies 'placement' before running 'fn'. Returns the error,
+     * after joining the thread, if the placement could not be applied; 'fn' does not run
+     * in that case.
+     */
+    template<typename F>
+    [[nodiscard]]
+    std::expected<std::thread, LinuxError> spawn_thread(const Placement& placement, F&& fn) {
+        std::promise<std::optional<LinuxError>> placed;
+        auto result = placed.get_future();
+
+        std::thread thread([placement, placed = std::move(placed), fn = std::forward<F>(fn)]() mutable {
+            const auto err = placement.apply();
+            const bool ok = !err.has_value();
+            placed.set_value(err);
+            if (ok) {
+                fn();
+            }
+        });
+
+        const auto err = result.get();
+        if (err.has_value()) {
+            thread.join();
+            return std::unexpected(err.value());
+        }
+        return thread;
+    }
+
+    inline std::expected<Process, LinuxError> Process::fork(const Placement& placement, std::function<int()>&& fn) {
+        return fork([&placement, fn = std::move(fn)]() {
+            if (placement.apply().has_value()) {
+                return PLACEMENT_FAILED;
+            }
+            return fn();
+        });
+    }
+}
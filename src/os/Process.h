@@ -1,7 +1,9 @@
 #pragma once
 
+#include <signal.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <functional>
 #include <optional>
 #include <cstdlib>
@@ -15,6 +17,8 @@
 #include "os/LinuxError.h"
 
 namespace conq {
+    struct Placement;
+
     class Process final {
     public:
         explicit Process(int pid) : m_pid(pid) {}
@@ -30,6 +34,38 @@ namespace conq {
             return WEXITSTATUS(status);
         }
 
+        /**
+         * Reaps the process if it has terminated: nullopt while it is still running,
+         * otherwise its exit status, or 128 + the signal number if it was killed.
+         */
+        [[nodiscard]]
+        std::expected<std::optional<int>, LinuxError> try_wait() const {
+            int status{};
+            const auto pid = waitpid(m_pid, &status, WNOHANG);
+            if (pid == -1) {
+                return LinuxError::errno_v();
+            }
+            if (pid == 0) {
+                return std::nullopt;
+            }
+
+            return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+        }
+
+        [[nodiscard]]
+        std::optional<LinuxError> kill(int signal) const {
+            if (::kill(m_pid, signal) == -1) {
+                return LinuxError(errno);
+            }
+
+            return std::nullopt;
+        }
+
+        [[nodiscard]]
+        int pid() const noexcept {
+            return m_pid;
+        }
+
     public:
         static std::expected<Process, LinuxError> fork(std::function<int()>&& fn) {
             prepare();
@@ -46,6 +82,15 @@ namespace conq {
             return Process(pid);
         }
 
+        /**
+         * Forks a child that applies 'placement' before running 'fn'. If the placement
+         * fails, the child exits with PLACEMENT_FAILED without running 'fn'. Defined in
+         * os/Placement.h.
+         */
+        static std::expected<Process, LinuxError> fork(const Placement& placement, std::function<int()>&& fn);
+
+        static constexpr int PLACEMENT_FAILED = 125;
+
     private:
         static void prepare() {
             std::fflush(stdout);
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <time.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Definitions.h"
+#include "SPSCBoundedQueue.h"
+#include "os/LinuxError.h"
+#include "os/Placement.h"
+#include "os/Process.h"
+#include "os/ShMem.h"
+
+namespace conq {
+    enum class TaskStatus {
+        Done,
+        /** The worker died while running the task; the worker has been replaced. */
+        Crashed,
+    };
+
+    template<typename Result>
+    struct Completion final {
+        std::uint64_t id{};
+        TaskStatus status{};
+        /** Meaningful only when status is Done. */
+        Result result{};
+    };
+
+    /**
+     * Pre-forked worker processes. Each worker has an SPSC inbox and an SPSC mailbox in
+     * a ShMem segment, with the parent on the other end of both, so a worker that dies
+     * mid-operation cannot leave state another process waits on. submit() hands a task
+     * to the worker with the fewest outstanding tasks. Task and Result cross process
+     * boundaries by value and must be trivially copyable.
+     *
+     * The parent drives the pool with submit() and poll(). poll() collects results,
+     * notices workers that died (crash, signal, exit), reports the task they were
+     * running as Crashed and forks a replacement. A task leaves its inbox only after
+     * its result is in the mailbox, so tasks still queued for a dead worker go to the
+     * replacement, and every task is reported exactly once.
+     */
+    template<QElement Task, QElement Result, std::size_t MAX_WORKERS = 16, std::size_t LEN = 256>
+    requires std::is_trivially_copyable_v<Task> && std::is_trivially_copyable_v<Result> && PowerOfTwo<LEN>
+    class ProcessPool final {
+    public:
+        using Function = std::function<Result(const Task&)>;
+
+    private:
+        struct TaskEnvelope {
+            std::uint64_t id{};
+            Task task{};
+        };
+
+        struct ResultEnvelope {
+            std::uint64_t id{};
+            Result result{};
+        };
+
+        struct alignas (CACHE_LINE_SIZE) WorkerState {
+            std::atomic<std::uint64_t> in_flight{};
+        };
+
+        struct Shared {
+            std::array<SPSCMailBox<TaskEnvelope, LEN>, MAX_WORKERS> inboxes;
+            std::array<SPSCMailBox<ResultEnvelope, LEN>, MAX_WORKERS> results;
+            std::array<WorkerState, MAX_WORKERS> workers;
+            alignas (CACHE_LINE_SIZE) std::atomic<bool> stop{};
+        };
+
+        /**
+         * The parent's view of a worker. Each inbox is FIFO and ids only grow, so a
+         * worker completes its tasks in id order.
+         */
+        struct Worker {
+            Process process;
+            std::uint64_t last_done{};
+            std::size_t outstanding{};
+        };
+
+        ProcessPool(ShMem&& shmem, Shared* shared, Function&& fn, std::vector<Placement>&& placements) :
+                m_shmem(std::move(shmem)),
+                m_shared(shared),
+                m_fn(std::move(fn)),
+                m_placements(std::move(placements)) {}
+
+    public:
+        ProcessPool(const ProcessPool&) = delete;
+        ProcessPool& operator=(const ProcessPool&) = delete;
+
+        ProcessPool(ProcessPool&& other) noexcept :
+                m_shmem(std::move(other.m_shmem)),
+                m_shared(std::exchange(other.m_shared, nullptr)),
+                m_fn(std::move(other.m_fn)),
+                m_placements(std::move(other.m_placements)),
+                m_workers(std::move(other.m_workers)),
+                m_next_id(other.m_next_id),
+                m_respawns(other.m_respawns) {}
+
+        /**
+         * Asks the workers to finish and waits for them. A worker stuck inside a task
+         * keeps the destructor waiting.
+         */
+        ~ProcessPool() {
+            if (m_shared == nullptr) {
+                return;
+            }
+
+            m_shared->stop.store(true, std::memory_order_release);
+            for (const auto& worker: m_workers) {
+                (void) worker.process.wait();
+            }
+        }
+
+    public:
+        /**
+         * Queues a task and returns its id, or nullopt when every inbox is full. Tries
+         * each inbox once, so a busy or dead worker never blocks the caller.
+         */
+        [[nodiscard]]
+        std::optional<std::uint64_t> submit(const Task& task) {
+            const auto id = m_next_id;
+            const auto first = least_loaded();
+            for (std::size_t n = 0; n < m_workers.size(); ++n) {
+                const auto i = (first + n) % m_workers.size();
+                if (m_shared->inboxes[i].try_push(TaskEnvelope{id, task})) {
+                    ++m_workers[i].outstanding;
+                    ++m_next_id;
+                    return id;
+                }
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * Collects finished tasks and replaces dead workers. Call it regularly: workers
+         * whose mailbox is full wait for it.
+         */
+        [[nodiscard]]
+        std::expected<std::vector<Completion<Result>>, LinuxError> poll() {
+            std::vector<Completion<Result>> completions;
+            for (std::size_t i = 0; i < m_workers.size(); ++i) {
+                drain(i, completions);
+
+                const auto exited = m_workers[i].process.try_wait();
+                if (!exited.has_value()) {
+                    return std::unexpected(exited.error());
+                }
+                if (!exited->has_value()) {
+                    continue;
+                }
+
+                // The worker is gone, so its mailbox is final: results it did deliver count.
+                drain(i, completions);
+                reclaim(i, completions);
+
+                auto replacement = spawn(i);
+                if (!replacement.has_value()) {
+                    return std::unexpected(replacement.error());
+                }
+                m_workers[i].process = replacement.value();
+                ++m_respawns;
+            }
+            return completions;
+        }
+
+        [[nodiscard]]
+        std::size_t workers() const noexcept {
+            return m_workers.size();
+        }
+
+        [[nodiscard]]
+        std::size_t respawns() const noexcept {
+            return m_respawns;
+        }
+
+        [[nodiscard]]
+        std::vector<int> pids() const {
+            std::vector<int> pids;
+            for (const auto& worker: m_workers) {
+                pids.push_back(worker.process.pid());
+            }
+            return pids;
+        }
+
+    public:
+        /**
+         * Starts 'workers' processes running 'fn'. Worker i is placed with
+         * placements[i % placements.size()] when placements are given.
+         */
+        [[nodiscard]]
+        static std::expected<ProcessPool, LinuxError> create(std::size_t workers, Function fn, std::span<const Placement> placements = {}) {
+            if (workers == 0 || workers > MAX_WORKERS) {
+                return LinuxError::unexpect(EINVAL);
+            }
+
+            static std::atomic<int> counter{};
+            const auto name = "/conq_pool_" + std::to_string(getpid()) + "_" + std::to_string(counter.fetch_add(1));
+            auto shmem = ShMem::create(name);
+            if (!shmem.has_value()) {
+                return std::unexpected(shmem.error());
+            }
+
+            const auto shared = shmem->template allocate<Shared>();
+            if (shared == nullptr) {
+                return LinuxError::errno_v();
+            }
+
+            ProcessPool pool(std::move(shmem.value()), shared, std::move(fn), {placements.begin(), placements.end()});
+            for (std::size_t i = 0; i < workers; ++i) {
+                auto worker = pool.spawn(i);
+                if (!worker.has_value()) {
+                    return std::unexpected(worker.error());
+                }
+                pool.m_workers.push_back(Worker{worker.value()});
+            }
+            return pool;
+        }
+
+    private:
+        std::expected<Process, LinuxError> spawn(std::size_t index) {
+            const auto placement = m_placements.empty() ? Placement{} : m_placements[index % m_placements.size()];
+            return Process::fork(placement, [shared = m_shared, index, &fn = m_fn]() {
+                return work(*shared, index, fn);
+            });
+        }
+
+        void drain(std::size_t index, std::vector<Completion<Result>>& completions) {
+            auto& mailbox = m_shared->results[index];
+            auto& worker = m_workers[index];
+            for (auto envelope = mailbox.try_pop(); envelope.has_value(); envelope = mailbox.try_pop()) {
+                completions.push_back({envelope->id, TaskStatus::Done, envelope->result});
+                worker.last_done = envelope->id;
+                --worker.outstanding;
+            }
+        }
+
+        /**
+         * Settles the inbox of a dead worker after its last drain(); the parent is its
+         * only user until the replacement starts. The worker may have died after
+         * delivering the task at the front but before removing it, or while running it.
+         */
+        void reclaim(std::size_t index, std::vector<Completion<Result>>& completions) {
+            auto& inbox = m_shared->inboxes[index];
+            auto& worker = m_workers[index];
+            const auto in_flight = m_shared->workers[index].in_flight.exchange(0, std::memory_order_acquire);
+            const auto front = inbox.front();
+            if (!front.has_value() || (front->id > worker.last_done && front->id != in_flight)) {
+                return;
+            }
+
+            (void) inbox.try_pop();
+            if (front->id > worker.last_done) {
+                completions.push_back({front->id, TaskStatus::Crashed, Result{}});
+                --worker.outstanding;
+            }
+        }
+
+        [[nodiscard]]
+        std::size_t least_loaded() const noexcept {
+            std::size_t best = 0;
+            for (std::size_t i = 1; i < m_workers.size(); ++i) {
+                if (m_workers[i].outstanding < m_workers[best].outstanding) {
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        /**
+         * Spins, then yields, then sleeps, so idle workers give the CPU back.
+         */
+        class Idle final {
+        public:
+            void wait() noexcept {
+                ++m_rounds;
+                if (m_rounds < SPINS) {
+                    return;
+                }
+                if (m_rounds < SPINS + YIELDS) {
+                    std::this_thread::yield();
+                    return;
+                }
+
+                timespec pause{0, SLEEP_NS};
+                nanosleep(&pause, nullptr);
+            }
+
+            void reset() noexcept {
+                m_rounds = 0;
+            }
+
+        private:
+            static constexpr int SPINS = 64;
+            static constexpr int YIELDS = 64;
+            static constexpr long SLEEP_NS = 50'000;
+            int m_rounds{};
+        };
+
+        static int work(Shared& shared, std::size_t index, const Function& fn) {
+            auto& inbox = shared.inboxes[index];
+            auto& mailbox = shared.results[index];
+            auto& state = shared.workers[index];
+            Idle idle;
+            while (!shared.stop.load(std::memory_order_acquire)) {
+                // Left in the inbox until the result is delivered; see reclaim().
+                const auto envelope = inbox.front();
+                if (!envelope.has_value()) {
+                    idle.wait();
+                    continue;
+                }
+
+                idle.reset();
+                state.in_flight.store(envelope->id, std::memory_order_release);
+                const ResultEnvelope result{envelope->id, fn(envelope->task)};
+                while (!mailbox.try_push(result)) {
+                    if (shared.stop.load(std::memory_order_acquire)) {
+                        return 0;
+                    }
+                    idle.wait();
+                }
+                (void) inbox.try_pop();
+                state.in_flight.store(0, std::memory_order_release);
+            }
+            return 0;
+        }
+
+        ShMem m_shmem;
+        Shared* m_shared;
+        Function m_fn;
+        std::vector<Placement> m_placements;
+        std::vector<Worker> m_workers{};
+        std::uint64_t m_next_id{1};
+        std::size_t m_respawns{};
+    };
+}
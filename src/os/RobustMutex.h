@@ -0,0 +1,299 @@
+#pragma once
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <expected>
+#include <optional>
+
+#include "Definitions.h"
+#include "os/Futex.h"
+#include "os/LinuxError.h"
+
+namespace conq {
+    enum class Acquired {
+        Clean,
+        /**
+         * The previous owner died holding the lock. The lock is usable again, but the
+         * data it guards may be half-updated and should be checked or rebuilt.
+         */
+        OwnerDied,
+    };
+
+    /**
+     * Process-shared mutex that survives its owner crashing: the next lock() returns
+     * Acquired::OwnerDied instead of hanging. Construct it in a ShMem segment.
+     *
+     * It is a PTHREAD_MUTEX_ROBUST pthread mutex rather than a hand-rolled futex
+     * because recovery depends on the kernel walking the dead thread's robust list, and
+     * glibc already registers that list for every thread (set_robust_list accepts one
+     * list per thread). glibc also makes the mutex consistent again for us here, so
+     * callers never see ENOTRECOVERABLE.
+     */
+    class RobustMutex final {
+    public:
+        RobustMutex() {
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+            pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+            [[maybe_unused]] const auto err = pthread_mutex_init(&m_mutex, &attr);
+            pthread_mutexattr_destroy(&attr);
+            assert(err == 0 && "pthread_mutex_init failed");
+        }
+
+        ~RobustMutex() {
+            pthread_mutex_destroy(&m_mutex);
+        }
+
+        RobustMutex(const RobustMutex&) = delete;
+        RobustMutex& operator=(const RobustMutex&) = delete;
+
+    public:
+        [[nodiscard]]
+        std::expected<Acquired, LinuxError> lock() {
+            return acquired(pthread_mutex_lock(&m_mutex));
+        }
+
+        /**
+         * Fails with EBUSY if another thread holds the mutex.
+         */
+        [[nodiscard]]
+        std::expected<Acquired, LinuxError> try_lock() {
+            return acquired(pthread_mutex_trylock(&m_mutex));
+        }
+
+        /**
+         * Fails with ETIMEDOUT if the mutex could not be taken within 'timeout'.
+         */
+        [[nodiscard]]
+        std::expected<Acquired, LinuxError> try_lock_for(std::chrono::nanoseconds timeout) {
+            const auto deadline = futex::deadline_after(timeout);
+            return acquired(pthread_mutex_clocklock(&m_mutex, CLOCK_MONOTONIC, &deadline));
+        }
+
+        void unlock() {
+            pthread_mutex_unlock(&m_mutex);
+        }
+
+    private:
+        friend class RobustCondition;
+
+        std::expected<Acquired, LinuxError> acquired(int err) {
+            if (err == 0) {
+                return Acquired::Clean;
+            }
+            if (err == EOWNERDEAD) {
+                pthread_mutex_consistent(&m_mutex);
+                return Acquired::OwnerDied;
+            }
+            return LinuxError::unexpect(err);
+        }
+
+        pthread_mutex_t m_mutex{};
+    };
+
+    /**
+     * Process-shared condition variable for RobustMutex, timed on CLOCK_MONOTONIC.
+     * wait() reacquires the mutex and therefore reports a dead owner like lock().
+     */
+    class RobustCondition final {
+    public:
+        RobustCondition() {
+            pthread_condattr_t attr;
+            pthread_condattr_init(&attr);
+            pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+            pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+            [[maybe_unused]] const auto err = pthread_cond_init(&m_cond, &attr);
+            pthread_condattr_destroy(&attr);
+            assert(err == 0 && "pthread_cond_init failed");
+        }
+
+        ~RobustCondition() {
+            pthread_cond_destroy(&m_cond);
+        }
+
+        RobustCondition(const RobustCondition&) = delete;
+        RobustCondition& operator=(const RobustCondition&) = delete;
+
+    public:
+        [[nodiscard]]
+        std::expected<Acquired, LinuxError> wait(RobustMutex& mutex) {
+            return mutex.acquired(pthread_cond_wait(&m_cond, &mutex.m_mutex));
+        }
+
+        /**
+         * Fails with ETIMEDOUT, holding the mutex again, if not notified within 'timeout'.
+         */
+        [[nodiscard]]
+        std::expected<Acquired, LinuxError> wait_for(RobustMutex& mutex, std::chrono::nanoseconds timeout) {
+            const auto deadline = futex::deadline_after(timeout);
+            return mutex.acquired(pthread_cond_timedwait(&m_cond, &mutex.m_mutex, &deadline));
+        }
+
+        void notify_one() {
+            pthread_cond_signal(&m_cond);
+        }
+
+        void notify_all() {
+            pthread_cond_broadcast(&m_cond);
+        }
+
+    private:
+        pthread_cond_t m_cond{};
+    };
+
+    /**
+     * Reader-writer lock for read-mostly data in shared memory. Each reader thread
+     * claims a slot on its own cache line, so read locks touch no line shared with
+     * other readers; a writer takes a RobustMutex, raises a flag and waits for every
+     * slot to drain.
+     *
+     * Crashes are recovered through the same kernel robust-list cleanup as
+     * RobustMutex: a registered reader holds its slot's mutex, so a writer can tell a
+     * dead reader from a slow one and skips its slot, and readers blocked behind a
+     * dead writer clear the flag themselves. The next write lock after a writer died
+     * returns Acquired::OwnerDied.
+     *
+     * register_reader() and unregister_reader() must run on the same thread. Read
+     * locks are not reentrant; one slot holds one read lock at a time.
+     */
+    template<std::size_t READERS = 64>
+    class RobustRwLock final {
+    public:
+        RobustRwLock() = default;
+
+        RobustRwLock(const RobustRwLock&) = delete;
+        RobustRwLock& operator=(const RobustRwLock&) = delete;
+
+    public:
+        /**
+         * Claims a reader slot for the calling thread, reusing slots of dead threads.
+         * Returns nullopt when all slots are taken.
+         */
+        [[nodiscard]]
+        std::optional<std::size_t> register_reader() {
+            for (std::size_t i = 0; i < READERS; ++i) {
+                auto& slot = m_slots[i];
+                if (slot.owner.try_lock().has_value()) {
+                    slot.active.store(0, std::memory_order_release);
+                    return i;
+                }
+            }
+            return std::nullopt;
+        }
+
+        void unregister_reader(std::size_t slot) {
+            m_slots[slot].owner.unlock();
+        }
+
+        void lock_shared(std::size_t index) {
+            auto& slot = m_slots[index];
+            while (true) {
+                // seq_cst against the writer's flag store: one of the two sees the other.
+                slot.active.store(1, std::memory_order_seq_cst);
+                if (m_writer.load(std::memory_order_seq_cst) == 0) {
+                    return;
+                }
+
+                release_slot(slot);
+                wait_for_writer();
+            }
+        }
+
+        void unlock_shared(std::size_t index) {
+            release_slot(m_slots[index]);
+        }
+
+        [[nodiscard]]
+        std::expected<Acquired, LinuxError> lock() {
+            auto acquired = m_mutex.lock();
+            if (!acquired.has_value()) {
+                return acquired;
+            }
+            if (m_writer_died.exchange(false, std::memory_order_relaxed)) {
+                acquired = Acquired::OwnerDied;
+            }
+
+            m_writer.store(WRITING, std::memory_order_seq_cst);
+            for (auto& slot: m_slots) {
+                drain(slot);
+            }
+            return acquired;
+        }
+
+        void unlock() {
+            m_writer.store(0, std::memory_order_seq_cst);
+            futex::wake(m_writer, INT_MAX);
+            m_mutex.unlock();
+        }
+
+    private:
+        struct alignas (CACHE_LINE_SIZE) Slot {
+            std::atomic<std::uint32_t> active{};
+            RobustMutex owner{};
+        };
+
+        static constexpr std::uint32_t WRITING = 1;
+        static constexpr auto LIVENESS_CHECK = std::chrono::milliseconds(10);
+
+        void release_slot(Slot& slot) {
+            slot.active.store(0, std::memory_order_seq_cst);
+            if (m_writer.load(std::memory_order_seq_cst) != 0) {
+                futex::wake(slot.active, 1);
+            }
+        }
+
+        void drain(Slot& slot) {
+            for (int i = 0; i < futex::SPINS && slot.active.load(std::memory_order_seq_cst) != 0; ++i) {
+                cpu_relax();
+            }
+
+            while (slot.active.load(std::memory_order_seq_cst) != 0) {
+                // Only a dead reader leaves its slot active without holding the slot.
+                if (slot.owner.try_lock().has_value()) {
+                    slot.active.store(0, std::memory_order_relaxed);
+                    slot.owner.unlock();
+                    return;
+                }
+
+                const auto deadline = futex::deadline_after(LIVENESS_CHECK);
+                (void) futex::wait(slot.active, 1, &deadline);
+            }
+        }
+
+        void wait_for_writer() {
+            while (m_writer.load(std::memory_order_acquire) != 0) {
+                const auto deadline = futex::deadline_after(LIVENESS_CHECK);
+                if (futex::wait(m_writer, WRITING, &deadline) == ETIMEDOUT) {
+                    recover();
+                }
+            }
+        }
+
+        // A live writer holds m_mutex while the flag is up; getting it means the writer died.
+        void recover() {
+            if (!m_mutex.try_lock().has_value()) {
+                return;
+            }
+            if (m_writer.load(std::memory_order_relaxed) != 0) {
+                m_writer_died.store(true, std::memory_order_relaxed);
+                m_writer.store(0, std::memory_order_seq_cst);
+                futex::wake(m_writer, INT_MAX);
+            }
+            m_mutex.unlock();
+        }
+
+        RobustMutex m_mutex;
+        alignas (CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_writer{};
+        std::atomic<bool> m_writer_died{};
+        std::array<Slot, READERS> m_slots{};
+    };
+}
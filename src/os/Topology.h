@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "os/LinuxError.h"
+
+namespace conq {
+    /**
+     * Parses a kernel CPU/node list such as "0-3,8,10-11".
+     */
+    inline std::vector<int> parse_cpu_list(std::string_view text) {
+        std::vector<int> result;
+        while (!text.empty()) {
+            const auto comma = text.find(',');
+            const auto item = text.substr(0, comma);
+            text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+
+            int first{};
+            auto [end, ec] = std::from_chars(item.data(), item.data() + item.size(), first);
+            if (ec != std::errc{}) {
+                continue;
+            }
+
+            int last = first;
+            if (end != item.data() + item.size() && *end == '-') {
+                std::from_chars(end + 1, item.data() + item.size(), last);
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                result.push_back(cpu);
+            }
+        }
+        return result;
+    }
+
+    enum class CpuRelation {
+        SameCpu,
+        SmtSibling,
+        SharedL3,
+        SameSocket,
+        CrossSocket,
+    };
+
+    inline const char* to_string(CpuRelation relation) noexcept {
+        switch (relation) {
+            case CpuRelation::SameCpu: return "same-cpu";
+            case CpuRelation::SmtSibling: return "smt-sibling";
+            case CpuRelation::SharedL3: return "shared-l3";
+            case CpuRelation::SameSocket: return "same-socket";
+            case CpuRelation::CrossSocket: return "cross-socket";
+        }
+        std::unreachable();
+    }
+
+    struct Cpu final {
+        int id{};
+        int core{};
+        int package{};
+        int node{};
+        /** Lowest CPU sharing this CPU's L3, i.e. an id of its L3 domain; -1 if unknown. */
+        int l3{-1};
+    };
+
+    /**
+     * Online CPUs with their core, socket, L3 domain and NUMA node, read from sysfs.
+     * Use it to put both ends of a channel on cores that share a cache, or a worker on
+     * the node that holds its memory.
+     */
+    class Topology final {
+    private:
+        explicit Topology(std::vector<Cpu>&& cpus) :
+                m_cpus(std::move(cpus)) {}
+
+    public:
+        [[nodiscard]]
+        const std::vector<Cpu>& cpus() const noexcept {
+            return m_cpus;
+        }
+
+        [[nodiscard]]
+        const Cpu* cpu(int id) const noexcept {
+            const auto it = std::ranges::find(m_cpus, id, &Cpu::id);
+            return it == m_cpus.end() ? nullptr : &*it;
+        }
+
+        /**
+         * CPUs on the same physical core as 'id', including 'id' itself.
+         */
+        [[nodiscard]]
+        std::vector<int> smt_siblings(int id) const {
+            const auto self = cpu(id);
+            return select([&](const Cpu& other) {
+                return self != nullptr && other.package == self->package && other.core == self->core;
+            });
+        }
+
+        [[nodiscard]]
+        std::vector<int> l3_domain(int id) const {
+            const auto self = cpu(id);
+            return select([&](const Cpu& other) {
+                return self != nullptr && self->l3 != -1 && other.l3 == self->l3;
+            });
+        }
+
+        [[nodiscard]]
+        std::vector<int> node_cpus(int node) const {
+            return select([&](const Cpu& other) {
+                return other.node == node;
+            });
+        }
+
+        [[nodiscard]]
+        std::vector<int> nodes() const {
+            return distinct(&Cpu::node);
+        }
+
+        [[nodiscard]]
+        std::size_t cores() const {
+            std::set<std::pair<int, int>> cores;
+            for (const auto& cpu: m_cpus) {
+                cores.emplace(cpu.package, cpu.core);
+            }
+            return cores.size();
+        }
+
+        [[nodiscard]]
+        std::size_t sockets() const {
+            return distinct(&Cpu::package).size();
+        }
+
+        /**
+         * How close two CPUs are; the closest applicable relation wins. Unknown CPUs are
+         * reported as CrossSocket.
+         */
+        [[nodiscard]]
+        CpuRelation relation(int a, int b) const noexcept {
+            const auto first = cpu(a);
+            const auto second = cpu(b);
+            if (first == nullptr || second == nullptr) {
+                return CpuRelation::CrossSocket;
+            }
+            if (a == b) {
+                return CpuRelation::SameCpu;
+            }
+            if (first->package != second->package) {
+                return CpuRelation::CrossSocket;
+            }
+            if (first->core == second->core) {
+                return CpuRelation::SmtSibling;
+            }
+            if (first->l3 != -1 && first->l3 == second->l3) {
+                return CpuRelation::SharedL3;
+            }
+            return CpuRelation::SameSocket;
+        }
+
+    public:
+        /**
+         * 'root' is the sysfs system directory; it is a parameter so tests can point it at
+         * a fabricated tree.
+         */
+        [[nodiscard]]
+        static std::expected<Topology, LinuxError> query(const std::filesystem::path& root = "/sys/devices/system") {
+            const auto online = read_line(root / "cpu" / "online");
+            if (!online.has_value()) {
+                return LinuxError::unexpect(ENOENT);
+            }
+
+            std::vector<Cpu> cpus;
+            for (const auto id: parse_cpu_list(online.value())) {
+                const auto dir = root / "cpu" / ("cpu" + std::to_string(id));
+                Cpu cpu{};
+                cpu.id = id;
+                cpu.core = read_int(dir / "topology" / "core_id").value_or(id);
+                cpu.package = read_int(dir / "topology" / "physical_package_id").value_or(0);
+                cpu.l3 = l3_of(dir / "cache");
+                cpus.push_back(cpu);
+            }
+
+            std::error_code ec;
+            for (const auto& entry: std::filesystem::directory_iterator(root / "node", ec)) {
+                const auto name = entry.path().filename().string();
+                if (!name.starts_with("node") || name.size() == 4 || !std::isdigit(static_cast<unsigned char>(name[4]))) {
+                    continue;
+                }
+
+                const auto node = std::stoi(name.substr(4));
+                for (const auto id: parse_cpu_list(read_line(entry.path() / "cpulist").value_or(""))) {
+                    for (auto& cpu: cpus) {
+                        if (cpu.id == id) {
+                            cpu.node = node;
+                        }
+                    }
+                }
+            }
+
+            return Topology(std::move(cpus));
+        }
+
+    private:
+        template<typename Predicate>
+        std::vector<int> select(Predicate&& predicate) const {
+            std::vector<int> result;
+            for (const auto& cpu: m_cpus) {
+                if (predicate(cpu)) {
+                    result.push_back(cpu.id);
+                }
+            }
+            return result;
+        }
+
+        std::vector<int> distinct(int Cpu::* field) const {
+            std::set<int> values;
+            for (const auto& cpu: m_cpus) {
+                values.insert(cpu.*field);
+            }
+            return {values.begin(), values.end()};
+        }
+
+        static std::optional<std::string> read_line(const std::filesystem::path& path) {
+            std::ifstream file(path);
+            std::string line;
+            if (!file || !std::getline(file, line)) {
+                return std::nullopt;
+            }
+            return line;
+        }
+
+        static std::optional<int> read_int(const std::filesystem::path& path) {
+            const auto line = read_line(path);
+            if (!line.has_value()) {
+                return std::nullopt;
+            }
+
+            int value{};
+            const auto [_, ec] = std::from_chars(line->data(), line->data() + line->size(), value);
+            return ec == std::errc{} ? std::optional(value) : std::nullopt;
+        }
+
+        static int l3_of(const std::filesystem::path& cache) {
+            std::error_code ec;
+            for (const auto& entry: std::filesystem::directory_iterator(cache, ec)) {
+                if (read_int(entry.path() / "level") != 3) {
+                    continue;
+                }
+
+                const auto shared = parse_cpu_list(read_line(entry.path() / "shared_cpu_list").value_or(""));
+                if (!shared.empty()) {
+                    return *std::ranges::min_element(shared);
+                }
+            }
+            return -1;
+        }
+
+        std::vector<Cpu> m_cpus;
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace conq {
+    /**
+     * Time stamp counter: a timestamp costs one rdtsc instead of a clock_gettime call.
+     * With an invariant TSC (constant rate, synchronised across cores, which all
+     * current x86 server parts provide) stamps taken on one core and consumed on
+     * another, even in another process, can be subtracted directly.
+     *
+     * Ticks are converted to nanoseconds with a calibration measured once per process,
+     * on first use of calibration(). Off x86 the counter is steady_clock in ns.
+     */
+    class Tsc final {
+    private:
+        Tsc(std::uint64_t mult, bool invariant) noexcept :
+                m_mult(mult),
+                m_invariant(invariant) {}
+
+    public:
+        [[nodiscard]]
+        static std::uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return steady_ns();
+#endif
+        }
+
+        [[nodiscard]]
+        static const Tsc& calibration() {
+            static const Tsc tsc = calibrate();
+            return tsc;
+        }
+
+        [[nodiscard]]
+        std::uint64_t to_ns(std::uint64_t ticks) const noexcept {
+            return static_cast<std::uint64_t>((static_cast<Wide>(ticks) * m_mult) >> SHIFT);
+        }
+
+        /**
+         * Nanoseconds since 'stamp' was taken by now(); 0 if the stamp lies in the future,
+         * which only happens with a non-invariant TSC.
+         */
+        [[nodiscard]]
+        std::uint64_t since(std::uint64_t stamp) const noexcept {
+            const auto current = now();
+            return current > stamp ? to_ns(current - stamp) : 0;
+        }
+
+        [[nodiscard]]
+        double ticks_per_ns() const noexcept {
+            return static_cast<double>(std::uint64_t{1} << SHIFT) / static_cast<double>(m_mult);
+        }
+
+        [[nodiscard]]
+        bool invariant() const noexcept {
+            return m_invariant;
+        }
+
+    private:
+        __extension__ typedef unsigned __int128 Wide;
+
+        static constexpr int SHIFT = 32;
+
+        static std::uint64_t steady_ns() noexcept {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        static Tsc calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned eax{}, ebx{}, ecx{}, edx{};
+            const bool invariant = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) != 0 && (edx & (1u << 8)) != 0;
+
+            // Busy-wait rather than sleep, so frequency scaling of an idle core cannot skew it.
+            const auto ns_begin = steady_ns();
+            const auto ticks_begin = now();
+            while (steady_ns() - ns_begin < CALIBRATION_NS) {}
+            const auto ticks = now() - ticks_begin;
+            const auto ns = steady_ns() - ns_begin;
+
+            const auto mult = (static_cast<Wide>(ns) << SHIFT) / ticks;
+            return {static_cast<std::uint64_t>(mult), invariant};
+#else
+            return {std::uint64_t{1} << SHIFT, true};
+#endif
+        }
+
+        static constexpr std::uint64_t CALIBRATION_NS = 20'000'000;
+
+        std::uint64_t m_mult;
+        bool m_invariant;
+    };
+}
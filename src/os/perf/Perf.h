@@ -2,85 +2,538 @@
 
 #include <linux/perf_event.h> /* Definition of PERF_* constants */
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/syscall.h> /* Definition of SYS_* constants */
 #include <unistd.h>
 
-#include "os/LinuxError.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
 #include <utility>
+#include <vector>
+
+#include "os/LinuxError.h"
 
 namespace conq::perf {
+    enum class Event: std::uint8_t {
+        CpuCycles,
+        Instructions,
+        CacheReferences,
+        CacheMisses,
+        L1dMisses,
+        BranchMisses,
+        ContextSwitches,
+        PageFaults,
+    };
+
+    inline constexpr std::size_t EVENT_COUNT = 8;
+
+    inline constexpr std::array<Event, EVENT_COUNT> ALL_EVENTS = {
+            Event::CpuCycles,
+            Event::Instructions,
+            Event::CacheReferences,
+            Event::CacheMisses,
+            Event::L1dMisses,
+            Event::BranchMisses,
+            Event::ContextSwitches,
+            Event::PageFaults,
+    };
+
+    /**
+     * The events counted on hardware PMCs: a group of only these can be read entirely
+     * with rdpmc (see Perf::read_fast()).
+     */
+    inline constexpr std::array<Event, 6> HARDWARE_EVENTS = {
+            Event::CpuCycles,
+            Event::Instructions,
+            Event::CacheReferences,
+            Event::CacheMisses,
+            Event::L1dMisses,
+            Event::BranchMisses,
+    };
+
+    inline const char* to_string(Event event) noexcept {
+        switch (event) {
+            case Event::CpuCycles: return "CPU Cycles";
+            case Event::Instructions: return "Instructions";
+            case Event::CacheReferences: return "Cache References";
+            case Event::CacheMisses: return "Cache Misses";
+            case Event::L1dMisses: return "L1D Misses";
+            case Event::BranchMisses: return "Branch Misses";
+            case Event::ContextSwitches: return "Context Switches";
+            case Event::PageFaults: return "Page Faults";
+        }
+        std::unreachable();
+    }
+
     class PerfData final {
     public:
-        explicit PerfData(long cpu_cycles) :
-                m_cpu_cycles(cpu_cycles) {}
+        PerfData() = default;
+
+        void set(Event event, std::uint64_t value) noexcept {
+            const auto index = static_cast<std::size_t>(event);
+            m_values[index] = value;
+            m_present.set(index);
+        }
+
+        [[nodiscard]]
+        std::optional<std::uint64_t> get(Event event) const noexcept {
+            const auto index = static_cast<std::size_t>(event);
+            if (!m_present.test(index)) {
+                return std::nullopt;
+            }
+
+            return m_values[index];
+        }
+
+        [[nodiscard]]
+        bool has(Event event) const noexcept {
+            return m_present.test(static_cast<std::size_t>(event));
+        }
+
+        [[nodiscard]]
+        std::optional<std::uint64_t> cpu_cycles() const noexcept {
+            return get(Event::CpuCycles);
+        }
+
+        /**
+         * Instructions retired per cycle.
+         */
+        [[nodiscard]]
+        std::optional<double> ipc() const noexcept {
+            return ratio(Event::Instructions, Event::CpuCycles, 1.0);
+        }
+
+        /**
+         * Fraction of last-level cache references that missed.
+         */
+        [[nodiscard]]
+        std::optional<double> cache_miss_rate() const noexcept {
+            return ratio(Event::CacheMisses, Event::CacheReferences, 1.0);
+        }
+
+        /**
+         * L1 data cache read misses per thousand instructions.
+         */
+        [[nodiscard]]
+        std::optional<double> l1d_mpki() const noexcept {
+            return ratio(Event::L1dMisses, Event::Instructions, 1000.0);
+        }
+
+        /**
+         * Branch mispredictions per thousand instructions.
+         */
+        [[nodiscard]]
+        std::optional<double> branch_mpki() const noexcept {
+            return ratio(Event::BranchMisses, Event::Instructions, 1000.0);
+        }
+
+        /**
+         * Accumulates the events present in other; events absent here are added.
+         */
+        PerfData& operator+=(const PerfData& other) noexcept {
+            for (std::size_t i = 0; i < EVENT_COUNT; ++i) {
+                if (other.m_present.test(i)) {
+                    m_values[i] += other.m_values[i];
+                    m_present.set(i);
+                }
+            }
+            return *this;
+        }
+
+        /**
+         * Difference of two readings; only events present in both are kept.
+         */
+        friend PerfData operator-(const PerfData& lhs, const PerfData& rhs) noexcept {
+            PerfData result{};
+            for (std::size_t i = 0; i < EVENT_COUNT; ++i) {
+                if (lhs.m_present.test(i) && rhs.m_present.test(i)) {
+                    result.m_values[i] = lhs.m_values[i] - rhs.m_values[i];
+                    result.m_present.set(i);
+                }
+            }
+            return result;
+        }
 
     public:
         friend std::ostream& operator<<(std::ostream& os, const PerfData& obj);
 
     private:
-        long m_cpu_cycles{};
+        [[nodiscard]]
+        std::optional<double> ratio(Event numerator, Event denominator, double scale) const noexcept {
+            const auto n = get(numerator);
+            const auto d = get(denominator);
+            if (!n.has_value() || !d.has_value() || d.value() == 0) {
+                return std::nullopt;
+            }
+
+            return scale * static_cast<double>(n.value()) / static_cast<double>(d.value());
+        }
+
+        std::array<std::uint64_t, EVENT_COUNT> m_values{};
+        std::bitset<EVENT_COUNT> m_present{};
     };
 
-    std::ostream& operator<<(std::ostream& os, const PerfData& obj) {
-        os << "CPU Cycles: " << obj.m_cpu_cycles;
+    inline std::ostream& operator<<(std::ostream& os, const PerfData& obj) {
+        bool first = true;
+        for (const auto event: ALL_EVENTS) {
+            const auto value = obj.get(event);
+            if (!value.has_value()) {
+                continue;
+            }
+
+            os << (first ? "" : " ") << to_string(event) << ": " << value.value();
+            first = false;
+        }
+
+        if (const auto ipc = obj.ipc()) {
+            os << " IPC: " << ipc.value();
+        }
+        if (const auto rate = obj.cache_miss_rate()) {
+            os << " Cache Miss Rate: " << rate.value();
+        }
+        if (const auto mpki = obj.l1d_mpki()) {
+            os << " L1D MPKI: " << mpki.value();
+        }
+        if (const auto mpki = obj.branch_mpki()) {
+            os << " Branch MPKI: " << mpki.value();
+        }
         return os;
     }
 
+    /**
+     * What a counter group observes: one thread, a thread together with the threads and
+     * processes it creates after the counters are opened, or everything running on a CPU.
+     */
+    class Target final {
+    private:
+        Target(pid_t pid, int cpu, bool inherit) noexcept :
+                m_pid(pid),
+                m_cpu(cpu),
+                m_inherit(inherit) {}
+
+    public:
+        [[nodiscard]]
+        pid_t pid() const noexcept {
+            return m_pid;
+        }
+
+        [[nodiscard]]
+        int cpu() const noexcept {
+            return m_cpu;
+        }
+
+        [[nodiscard]]
+        bool inherit() const noexcept {
+            return m_inherit;
+        }
+
+    public:
+        static Target calling_thread() noexcept {
+            return {0, -1, false};
+        }
+
+        static Target thread(pid_t tid) noexcept {
+            return {tid, -1, false};
+        }
+
+        static Target inherited(pid_t pid = 0) noexcept {
+            return {pid, -1, true};
+        }
+
+        /**
+         * System-wide on one CPU; usually requires CAP_PERFMON or perf_event_paranoid <= 0.
+         */
+        static Target cpu(int cpu) noexcept {
+            return {-1, cpu, false};
+        }
+
+    private:
+        pid_t m_pid;
+        int m_cpu;
+        bool m_inherit;
+    };
+
+    /**
+     * Group of counters for one Target, enabled, disabled and read together
+     * (PERF_FORMAT_GROUP) so every value in a PerfData covers the same interval.
+     * Events the machine cannot count are left out of the group and absent from PerfData.
+     *
+     * Each counter's perf page is also mapped so that read_fast() can sample hardware
+     * counters with rdpmc, without entering the kernel. Values read this way are raw
+     * counts, not scaled for multiplexing.
+     */
     class Perf final {
+    private:
+        struct Counter {
+            Event event;
+            int fd;
+            std::uint64_t id;
+            perf_event_mmap_page* page;
+        };
+
+        explicit Perf(std::vector<Counter>&& counters) :
+                m_counters(std::move(counters)) {}
+
     public:
-        explicit Perf(std::unique_ptr<perf_event_attr> &&pe, long fd) :
-                m_pe(std::move(pe)),
-                m_fd(fd) {}
+        Perf(const Perf&) = delete;
+        Perf& operator=(const Perf&) = delete;
 
         Perf(Perf &&other) noexcept :
-                m_pe(std::move(other.m_pe)),
-                m_fd(std::exchange(other.m_fd, -1)) {}
+                m_counters(std::move(other.m_counters)) {}
 
         ~Perf() {
-            if (m_fd == -1) {
-                return;
+            for (const auto& counter: m_counters) {
+                if (counter.page != nullptr) {
+                    munmap(counter.page, page_size());
+                }
+                close(counter.fd);
             }
-
-            close(static_cast<int>(m_fd));
         }
 
     public:
         void start() const noexcept {
-            const auto fd = static_cast<int>(m_fd);
-            const auto p1 = ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            [[maybe_unused]] const auto p1 = ioctl(leader(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
             assert_perror(p1);
 
-            const auto p2 = ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            [[maybe_unused]] const auto p2 = ioctl(leader(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
             assert_perror(p2);
         }
 
         void stop() const noexcept {
-            const auto p = ioctl(static_cast<int>(m_fd), PERF_EVENT_IOC_DISABLE, 0);
+            [[maybe_unused]] const auto p = ioctl(leader(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
             assert_perror(p);
         }
 
         [[nodiscard]]
         PerfData read() const noexcept {
-            long count{};
-            ::read(static_cast<int>(m_fd), &count, sizeof(count));
-            return PerfData(count);
+            PerfData data{};
+            read_group(data, true);
+            return data;
+        }
+
+        /**
+         * Raw counts: rdpmc for each counter currently on a hardware PMC, one read() for
+         * the rest (e.g. software events). Both paths give the same unscaled count, so
+         * two readings can be subtracted whichever path each counter took. Only a group
+         * of HARDWARE_EVENTS can avoid the syscall entirely.
+         */
+        [[nodiscard]]
+        PerfData read_fast() const noexcept {
+            PerfData data{};
+            bool complete = true;
+            for (const auto& counter: m_counters) {
+                const auto value = read_user(counter.page);
+                if (!value.has_value()) {
+                    complete = false;
+                    continue;
+                }
+
+                data.set(counter.event, value.value());
+            }
+
+            if (!complete) {
+                read_group(data, false);
+            }
+            return data;
         }
 
+        /**
+         * Whether read_fast() can avoid the syscall with the group as currently scheduled.
+         */
+        [[nodiscard]]
+        bool userspace_readable() const noexcept {
+            return std::ranges::all_of(m_counters, [](const Counter& c) { return read_user(c.page).has_value(); });
+        }
+
+        [[nodiscard]]
+        bool has(Event event) const noexcept {
+            return std::ranges::any_of(m_counters, [&](const Counter& c) { return c.event == event; });
+        }
+
+        /**
+         * Region marker: adds the raw counter deltas between construction and destruction
+         * to 'total'. The counters must be running (see start()); both ends use
+         * read_fast(), so open the group with HARDWARE_EVENTS to keep it syscall-free.
+         */
+        class Scope final {
+        public:
+            Scope(const Perf& perf, PerfData& total) noexcept :
+                    m_perf(perf),
+                    m_total(total),
+                    m_begin(perf.read_fast()) {}
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            ~Scope() {
+                m_total += m_perf.read_fast() - m_begin;
+            }
+
+        private:
+            const Perf& m_perf;
+            PerfData& m_total;
+            PerfData m_begin;
+        };
+
     public:
         [[nodiscard]]
         static std::expected<Perf, LinuxError> open() {
-            auto pe = std::make_unique<perf_event_attr>();
-            setup(pe.get(), PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            return open(Target::calling_thread(), ALL_EVENTS);
+        }
+
+        [[nodiscard]]
+        static std::expected<Perf, LinuxError> open(std::span<const Event> events) {
+            return open(Target::calling_thread(), events);
+        }
+
+        [[nodiscard]]
+        static std::expected<Perf, LinuxError> open(const Target& target, std::span<const Event> events = ALL_EVENTS) {
+            std::vector<Counter> counters;
+            int first_error = 0;
+            for (const auto event: events) {
+                if (std::ranges::any_of(counters, [&](const Counter& c) { return c.event == event; })) {
+                    continue;
+                }
+
+                perf_event_attr pe{};
+                setup(&pe, event);
+                pe.inherit = target.inherit() ? 1 : 0;
 
-            const auto fd = syscall(SYS_perf_event_open, pe.get(), 0, -1, -1, 0);
-            if (fd == -1) {
-                return LinuxError::errno_v();
+                const auto group = counters.empty() ? -1 : counters.front().fd;
+                const auto fd = static_cast<int>(syscall(SYS_perf_event_open, &pe, target.pid(), target.cpu(), group, 0));
+                if (fd == -1) {
+                    first_error = first_error == 0 ? errno : first_error;
+                    continue;
+                }
+
+                std::uint64_t id{};
+                if (ioctl(fd, PERF_EVENT_IOC_ID, &id) == -1) {
+                    first_error = first_error == 0 ? errno : first_error;
+                    close(fd);
+                    continue;
+                }
+                counters.push_back(Counter{event, fd, id, map_page(fd)});
+            }
+
+            if (counters.empty()) {
+                return LinuxError::unexpect(first_error);
             }
 
-            return Perf(std::move(pe), fd);
+            return Perf(std::move(counters));
         }
 
     private:
+        struct GroupReadFormat {
+            std::uint64_t nr;
+            std::uint64_t time_enabled;
+            std::uint64_t time_running;
+            struct {
+                std::uint64_t value;
+                std::uint64_t id;
+            } values[EVENT_COUNT];
+        };
+
+        /**
+         * One group read(); fills the events not already in 'data'.
+         */
+        void read_group(PerfData& data, bool scaled) const noexcept {
+            GroupReadFormat buffer{};
+            const auto size = ::read(leader(), &buffer, sizeof(buffer));
+            if (size <= 0) {
+                return;
+            }
+
+            for (std::uint64_t i = 0; i < buffer.nr; ++i) {
+                const auto& entry = buffer.values[i];
+                for (const auto& counter: m_counters) {
+                    if (counter.id == entry.id && !data.has(counter.event)) {
+                        data.set(counter.event, scaled ? scale(entry.value, buffer.time_enabled, buffer.time_running) : entry.value);
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]]
+        int leader() const noexcept {
+            return m_counters.front().fd;
+        }
+
+        static std::size_t page_size() noexcept {
+            static const auto size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            return size;
+        }
+
+        static perf_event_mmap_page* map_page(int fd) noexcept {
+            const auto page = mmap(nullptr, page_size(), PROT_READ, MAP_SHARED, fd, 0);
+            if (page == MAP_FAILED) {
+                return nullptr;
+            }
+
+            return static_cast<perf_event_mmap_page*>(page);
+        }
+
+        /**
+         * Seqlock-protected userspace read described in perf_event_open(2). Empty when the
+         * counter is not currently on a hardware PMC (software event, disabled, descheduled).
+         */
+        static std::optional<std::uint64_t> read_user(const perf_event_mmap_page* page) noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            if (page == nullptr) {
+                return std::nullopt;
+            }
+
+            const volatile auto* pc = page;
+            std::uint32_t seq;
+            std::uint64_t count;
+            do {
+                seq = pc->lock;
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+
+                const auto index = pc->index;
+                if (!pc->cap_user_rdpmc || index == 0) {
+                    return std::nullopt;
+                }
+
+                const auto width = pc->pmc_width;
+                auto pmc = static_cast<std::int64_t>(rdpmc(index - 1));
+                pmc <<= 64 - width;
+                pmc >>= 64 - width;
+                count = static_cast<std::uint64_t>(pc->offset + pmc);
+
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            } while (pc->lock != seq);
+
+            return count;
+#else
+            (void)page;
+            return std::nullopt;
+#endif
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        static std::uint64_t rdpmc(std::uint32_t counter) noexcept {
+            std::uint32_t low, high;
+            asm volatile("rdpmc" : "=a" (low), "=d" (high) : "c" (counter));
+            return (static_cast<std::uint64_t>(high) << 32) | low;
+        }
+#endif
+
+        static std::uint64_t scale(std::uint64_t value, std::uint64_t enabled, std::uint64_t running) noexcept {
+            // The kernel multiplexes groups that don't fit the PMU; extrapolate to the full interval.
+            if (running == 0 || running == enabled) {
+                return value;
+            }
+
+            return static_cast<std::uint64_t>(static_cast<double>(value) * static_cast<double>(enabled) / static_cast<double>(running));
+        }
+
         static void setup(perf_event_attr *pe, std::uint32_t type, std::uint64_t config) {
             pe->type = type;
             pe->size = sizeof(struct perf_event_attr);
@@ -88,10 +541,34 @@ namespace conq::perf {
             pe->disabled = 1;
             pe->exclude_kernel = 1;
             pe->exclude_hv = 1;
+            pe->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                    PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        }
+
+        static void setup(perf_event_attr *pe, Event event) {
+            switch (event) {
+                case Event::CpuCycles:
+                    return setup(pe, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+                case Event::Instructions:
+                    return setup(pe, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+                case Event::CacheReferences:
+                    return setup(pe, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+                case Event::CacheMisses:
+                    return setup(pe, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+                case Event::L1dMisses:
+                    return setup(pe, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+                case Event::BranchMisses:
+                    return setup(pe, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+                case Event::ContextSwitches:
+                    return setup(pe, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+                case Event::PageFaults:
+                    return setup(pe, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+            }
         }
 
     private:
-        std::unique_ptr<perf_event_attr> m_pe;
-        long m_fd = -1;
+        std::vector<Counter> m_counters;
     };
-}
\ No newline at end of file
+}
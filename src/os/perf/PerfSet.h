@@ -0,0 +1,175 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "os/perf/Perf.h"
+
+namespace conq::perf {
+    /**
+     * Several counter groups driven as one: per-thread groups for a set of threads, or
+     * per-CPU groups for system-wide measurement. read() sums the members.
+     */
+    class PerfSet final {
+    private:
+        explicit PerfSet(std::vector<Perf>&& members) :
+                m_members(std::move(members)) {}
+
+    public:
+        PerfSet(const PerfSet&) = delete;
+        PerfSet& operator=(const PerfSet&) = delete;
+        PerfSet(PerfSet&&) noexcept = default;
+
+    public:
+        void start() const noexcept {
+            for (const auto& perf: m_members) {
+                perf.start();
+            }
+        }
+
+        void stop() const noexcept {
+            for (const auto& perf: m_members) {
+                perf.stop();
+            }
+        }
+
+        [[nodiscard]]
+        PerfData read() const noexcept {
+            PerfData total{};
+            for (const auto& perf: m_members) {
+                total += perf.read();
+            }
+            return total;
+        }
+
+        [[nodiscard]]
+        std::vector<PerfData> read_each() const {
+            std::vector<PerfData> result;
+            result.reserve(m_members.size());
+            for (const auto& perf: m_members) {
+                result.push_back(perf.read());
+            }
+            return result;
+        }
+
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            return m_members.size();
+        }
+
+    public:
+        [[nodiscard]]
+        static std::expected<PerfSet, LinuxError> open(std::span<const Target> targets, std::span<const Event> events = ALL_EVENTS) {
+            std::vector<Perf> members;
+            members.reserve(targets.size());
+            for (const auto& target: targets) {
+                auto perf = Perf::open(target, events);
+                if (!perf.has_value()) {
+                    return std::unexpected(perf.error());
+                }
+                members.push_back(std::move(perf.value()));
+            }
+
+            return PerfSet(std::move(members));
+        }
+
+        [[nodiscard]]
+        static std::expected<PerfSet, LinuxError> threads(std::span<const pid_t> tids, std::span<const Event> events = ALL_EVENTS) {
+            std::vector<Target> targets;
+            for (const auto tid: tids) {
+                targets.push_back(Target::thread(tid));
+            }
+            return open(targets, events);
+        }
+
+        /**
+         * Every thread the process has right now, listed from /proc/<pid>/task. Threads
+         * started later are not covered; use Target::inherited for those.
+         */
+        [[nodiscard]]
+        static std::expected<PerfSet, LinuxError> process(pid_t pid, std::span<const Event> events = ALL_EVENTS) {
+            std::error_code ec;
+            std::vector<pid_t> tids;
+            const auto path = std::filesystem::path("/proc") / std::to_string(pid) / "task";
+            for (const auto& entry: std::filesystem::directory_iterator(path, ec)) {
+                tids.push_back(static_cast<pid_t>(std::stoi(entry.path().filename().string())));
+            }
+            if (ec) {
+                return LinuxError::unexpect(ec.value());
+            }
+
+            return threads(tids, events);
+        }
+
+        /**
+         * One group per online CPU, counting every task that runs there.
+         */
+        [[nodiscard]]
+        static std::expected<PerfSet, LinuxError> cpus(std::span<const Event> events = ALL_EVENTS) {
+            std::vector<Perf> members;
+            const auto configured = sysconf(_SC_NPROCESSORS_CONF);
+            for (int cpu = 0; cpu < configured; ++cpu) {
+                auto perf = Perf::open(Target::cpu(cpu), events);
+                if (perf.has_value()) {
+                    members.push_back(std::move(perf.value()));
+                    continue;
+                }
+                if (perf.error().code() != ENODEV) {
+                    return std::unexpected(perf.error());
+                }
+            }
+
+            return PerfSet(std::move(members));
+        }
+
+    private:
+        std::vector<Perf> m_members;
+    };
+
+    /**
+     * Labelled readings (e.g. "producer" and "consumer" of a queue) printed one per
+     * line, followed by their total.
+     */
+    class PerfReport final {
+    public:
+        PerfReport() = default;
+
+        void add(std::string label, const PerfData& data) {
+            m_entries.emplace_back(std::move(label), data);
+        }
+
+        [[nodiscard]]
+        PerfData total() const noexcept {
+            PerfData total{};
+            for (const auto& [_, data]: m_entries) {
+                total += data;
+            }
+            return total;
+        }
+
+        [[nodiscard]]
+        const std::vector<std::pair<std::string, PerfData>>& entries() const noexcept {
+            return m_entries;
+        }
+
+    public:
+        friend std::ostream& operator<<(std::ostream& os, const PerfReport& obj);
+
+    private:
+        std::vector<std::pair<std::string, PerfData>> m_entries;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const PerfReport& obj) {
+        for (const auto& [label, data]: obj.m_entries) {
+            os << label << ": " << data << '\n';
+        }
+        os << "total: " << obj.total();
+        return os;
+    }
+}
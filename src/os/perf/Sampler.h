@@ -0,0 +1,361 @@
+#pragma once
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "os/LinuxError.h"
+#include "os/perf/Perf.h"
+
+namespace conq::perf {
+    /**
+     * Resolves code addresses of the current process to demangled function names.
+     * Uses the dynamic symbol table (dladdr), so functions in the main executable are
+     * only named when it is linked with -rdynamic (CMake ENABLE_EXPORTS); otherwise the
+     * result is "module+0xoffset".
+     */
+    class Symbolizer final {
+    public:
+        Symbolizer() = default;
+
+        struct Symbol {
+            std::uintptr_t address;
+            std::string name;
+        };
+
+        const Symbol& resolve(std::uintptr_t ip) {
+            const auto it = m_cache.find(ip);
+            if (it != m_cache.end()) {
+                return it->second;
+            }
+
+            return m_cache.emplace(ip, lookup(ip)).first->second;
+        }
+
+    private:
+        static Symbol lookup(std::uintptr_t ip) {
+            Dl_info info{};
+            if (dladdr(reinterpret_cast<void*>(ip), &info) == 0) {
+                return {ip, hex(ip)};
+            }
+
+            if (info.dli_sname != nullptr) {
+                return {reinterpret_cast<std::uintptr_t>(info.dli_saddr), demangle(info.dli_sname)};
+            }
+
+            const auto base = reinterpret_cast<std::uintptr_t>(info.dli_fbase);
+            const auto module = info.dli_fname != nullptr ? std::string(info.dli_fname) : std::string("?");
+            return {ip, module + "+" + hex(ip - base)};
+        }
+
+        static std::string demangle(const char* name) {
+            int status{};
+            const auto demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+            if (status != 0 || demangled == nullptr) {
+                return name;
+            }
+
+            std::string result(demangled);
+            std::free(demangled);
+            return result;
+        }
+
+        static std::string hex(std::uintptr_t value) {
+            std::ostringstream os;
+            os << "0x" << std::hex << value;
+            return os.str();
+        }
+
+        std::unordered_map<std::uintptr_t, Symbol> m_cache;
+    };
+
+    struct HotSpot final {
+        std::string symbol;
+        std::size_t self{};
+        std::size_t total{};
+    };
+
+    /**
+     * Top functions of a profile: 'self' counts samples whose IP was in the function,
+     * 'total' counts samples with the function anywhere on the user call chain.
+     */
+    class HotSpotReport final {
+    public:
+        HotSpotReport(std::vector<HotSpot>&& spots, std::size_t samples, std::size_t lost) :
+                m_spots(std::move(spots)),
+                m_samples(samples),
+                m_lost(lost) {}
+
+        [[nodiscard]]
+        const std::vector<HotSpot>& spots() const noexcept {
+            return m_spots;
+        }
+
+        [[nodiscard]]
+        std::size_t samples() const noexcept {
+            return m_samples;
+        }
+
+        [[nodiscard]]
+        std::size_t lost() const noexcept {
+            return m_lost;
+        }
+
+    public:
+        friend std::ostream& operator<<(std::ostream& os, const HotSpotReport& obj);
+
+    private:
+        std::vector<HotSpot> m_spots;
+        std::size_t m_samples;
+        std::size_t m_lost;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const HotSpotReport& obj) {
+        const auto percent = [&](std::size_t n) {
+            return obj.m_samples == 0 ? 0.0 : 100.0 * static_cast<double>(n) / static_cast<double>(obj.m_samples);
+        };
+
+        os << "Samples: " << obj.m_samples << " Lost: " << obj.m_lost << '\n';
+        os << std::fixed << std::setprecision(2);
+        for (const auto& spot: obj.m_spots) {
+            os << std::setw(7) << percent(spot.self) << "% "
+               << std::setw(7) << percent(spot.total) << "%  "
+               << spot.symbol << '\n';
+        }
+        os << std::defaultfloat;
+        return os;
+    }
+
+    /**
+     * Sampling profiler: the kernel records the user IP and call chain of the target
+     * at a fixed frequency into a ring buffer shared with this process, and drain()
+     * folds the records into per-address counts. Samples cycles when the PMU is
+     * available and the cpu-clock software timer otherwise.
+     */
+    class Sampler final {
+    private:
+        Sampler(int fd, void* buffer, std::size_t buffer_size) noexcept :
+                m_fd(fd),
+                m_buffer(buffer),
+                m_buffer_size(buffer_size) {}
+
+    public:
+        Sampler(const Sampler&) = delete;
+        Sampler& operator=(const Sampler&) = delete;
+
+        Sampler(Sampler&& other) noexcept :
+                m_fd(std::exchange(other.m_fd, -1)),
+                m_buffer(std::exchange(other.m_buffer, nullptr)),
+                m_buffer_size(other.m_buffer_size),
+                m_symbolizer(std::move(other.m_symbolizer)),
+                m_self(std::move(other.m_self)),
+                m_total(std::move(other.m_total)),
+                m_samples(other.m_samples),
+                m_lost(other.m_lost) {}
+
+        ~Sampler() {
+            if (m_buffer != nullptr) {
+                munmap(m_buffer, m_buffer_size);
+            }
+            if (m_fd != -1) {
+                close(m_fd);
+            }
+        }
+
+    public:
+        void start() const noexcept {
+            [[maybe_unused]] const auto p = ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+            assert_perror(p);
+        }
+
+        void stop() const noexcept {
+            [[maybe_unused]] const auto p = ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            assert_perror(p);
+        }
+
+        /**
+         * Consumes every record currently in the ring buffer. Call it often enough that
+         * the buffer does not fill up; records that did not fit are reported as lost.
+         * Returns the number of samples consumed.
+         */
+        std::size_t drain() {
+            auto page = static_cast<perf_event_mmap_page*>(m_buffer);
+            const auto data = static_cast<const std::byte*>(m_buffer) + page->data_offset;
+            const auto size = page->data_size;
+
+            const auto head = std::atomic_ref(page->data_head).load(std::memory_order_acquire);
+            auto tail = page->data_tail;
+            std::size_t consumed = 0;
+            std::vector<std::byte> record;
+            while (tail < head) {
+                perf_event_header header{};
+                copy(data, size, tail, &header, sizeof(header));
+
+                record.resize(header.size);
+                copy(data, size, tail, record.data(), header.size);
+                tail += header.size;
+
+                if (header.type == PERF_RECORD_SAMPLE) {
+                    add_sample(record.data() + sizeof(header));
+                    ++consumed;
+                } else if (header.type == PERF_RECORD_LOST) {
+                    std::uint64_t lost[2]{};
+                    std::memcpy(lost, record.data() + sizeof(header), sizeof(lost));
+                    m_lost += lost[1];
+                }
+            }
+
+            std::atomic_ref(page->data_tail).store(tail, std::memory_order_release);
+            return consumed;
+        }
+
+        [[nodiscard]]
+        HotSpotReport report(std::size_t top) {
+            std::unordered_map<std::string, HotSpot> by_symbol;
+            for (const auto& [ip, count]: m_self) {
+                const auto& symbol = m_symbolizer.resolve(ip);
+                auto& spot = by_symbol[symbol.name];
+                spot.symbol = symbol.name;
+                spot.self += count;
+            }
+            for (const auto& [name, count]: m_total) {
+                auto& spot = by_symbol[name];
+                spot.symbol = name;
+                spot.total += count;
+            }
+
+            std::vector<HotSpot> spots;
+            spots.reserve(by_symbol.size());
+            for (auto& [_, spot]: by_symbol) {
+                spots.push_back(std::move(spot));
+            }
+
+            std::ranges::sort(spots, [](const HotSpot& a, const HotSpot& b) {
+                return std::tie(a.self, a.total) > std::tie(b.self, b.total);
+            });
+            if (spots.size() > top) {
+                spots.resize(top);
+            }
+
+            return {std::move(spots), m_samples, m_lost};
+        }
+
+    public:
+        /**
+         * 'pages' is the ring buffer size in pages and must be a power of two.
+         */
+        [[nodiscard]]
+        static std::expected<Sampler, LinuxError> open(const Target& target = Target::calling_thread(),
+                                                       std::uint64_t frequency = 1000,
+                                                       std::size_t pages = 64) {
+            if (pages == 0 || (pages & (pages - 1)) != 0) {
+                return LinuxError::unexpect(EINVAL);
+            }
+
+            perf_event_attr pe{};
+            setup(&pe, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, frequency);
+            pe.inherit = target.inherit() ? 1 : 0;
+
+            auto fd = static_cast<int>(syscall(SYS_perf_event_open, &pe, target.pid(), target.cpu(), -1, 0));
+            if (fd == -1) {
+                setup(&pe, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK, frequency);
+                fd = static_cast<int>(syscall(SYS_perf_event_open, &pe, target.pid(), target.cpu(), -1, 0));
+            }
+            if (fd == -1) {
+                return LinuxError::errno_v();
+            }
+
+            const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            const auto size = (pages + 1) * page_size;
+            const auto buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (buffer == MAP_FAILED) {
+                const auto err = LinuxError::errno_v();
+                close(fd);
+                return err;
+            }
+
+            return Sampler(fd, buffer, size);
+        }
+
+    private:
+        static void setup(perf_event_attr *pe, std::uint32_t type, std::uint64_t config, std::uint64_t frequency) {
+            *pe = perf_event_attr{};
+            pe->type = type;
+            pe->size = sizeof(struct perf_event_attr);
+            pe->config = config;
+            pe->disabled = 1;
+            pe->exclude_kernel = 1;
+            pe->exclude_hv = 1;
+            pe->exclude_callchain_kernel = 1;
+            pe->freq = 1;
+            pe->sample_freq = frequency;
+            pe->sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_CALLCHAIN;
+        }
+
+        static void copy(const std::byte* data, std::size_t size, std::uint64_t offset, void* out, std::size_t length) noexcept {
+            const auto start = offset & (size - 1);
+            const auto first = std::min<std::size_t>(length, size - start);
+            std::memcpy(out, data + start, first);
+            std::memcpy(static_cast<std::byte*>(out) + first, data, length - first);
+        }
+
+        void add_sample(const std::byte* payload) {
+            std::uint64_t ip{};
+            std::uint64_t nr{};
+            std::memcpy(&ip, payload, sizeof(ip));
+            std::memcpy(&nr, payload + sizeof(ip), sizeof(nr));
+            ++m_samples;
+            ++m_self[ip];
+
+            // Count each function once per sample, however deep its recursion.
+            std::unordered_set<std::string_view> seen;
+            const auto chain = payload + 2 * sizeof(std::uint64_t);
+            bool leaf = true;
+            for (std::uint64_t i = 0; i < nr; ++i) {
+                std::uint64_t frame{};
+                std::memcpy(&frame, chain + i * sizeof(frame), sizeof(frame));
+                if (frame >= PERF_CONTEXT_MAX) {
+                    continue;
+                }
+
+                // Return addresses point past the call; step back into the calling instruction.
+                const auto address = leaf ? frame : frame - 1;
+                leaf = false;
+                const auto& symbol = m_symbolizer.resolve(address);
+                if (seen.insert(symbol.name).second) {
+                    ++m_total[symbol.name];
+                }
+            }
+        }
+
+        int m_fd;
+        void* m_buffer;
+        std::size_t m_buffer_size;
+        Symbolizer m_symbolizer{};
+        std::unordered_map<std::uint64_t, std::size_t> m_self{};
+        std::unordered_map<std::string, std::size_t> m_total{};
+        std::size_t m_samples{};
+        std::size_t m_lost{};
+    };
+}
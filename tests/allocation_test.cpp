@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 
 #include "allocation/SeqAllocator.h"
+#include "allocation/SlotMap.h"
+#include "allocation/ShmPool.h"
+#include "allocation/MemoryResource.h"
+#include "allocation/SlabAllocator.h"
+#include "os/ShMem.h"
+#include "os/Process.h"
 
 TEST(Allocation, test1) {
     conq::memory::SeqAllocator<int, 2> allocator;
@@ -45,6 +51,240 @@ TEST(ObjPool, test1) {
     ASSERT_EQ(p.has_value(), false);
 }
 
+TEST(SlotMap, test1) {
+    conq::memory::SlotMap<int, 4> map;
+    const auto h1 = map.insert(1).value();
+    const auto h2 = map.insert(2).value();
+    const auto h3 = map.insert(3).value();
+    static_assert(sizeof(h1) == sizeof(std::uint32_t));
+
+    ASSERT_EQ(*map.get(h1), 1);
+    ASSERT_EQ(*map.get(h2), 2);
+    ASSERT_EQ(*map.get(h3), 3);
+    ASSERT_EQ(map.size(), 3);
+
+    ASSERT_TRUE(map.erase(h1));
+    ASSERT_FALSE(map.erase(h1));
+    ASSERT_EQ(map.get(h1), nullptr);
+    ASSERT_EQ(*map.get(h2), 2);
+    ASSERT_EQ(*map.get(h3), 3);
+
+    const auto h4 = map.insert(4).value();
+    ASSERT_EQ(h4.index(), h1.index());
+    ASSERT_NE(h4, h1);
+    ASSERT_EQ(map.get(h1), nullptr);
+    ASSERT_EQ(*map.get(h4), 4);
+
+    int sum = 0;
+    for (auto v: map) {
+        sum += v;
+    }
+    ASSERT_EQ(sum, 9);
+}
+
+TEST(SlotMap, test2) {
+    conq::memory::SlotMap<std::string, 2> map;
+    const auto h1 = map.insert("a").value();
+    const auto h2 = map.insert("b").value();
+    ASSERT_FALSE(map.insert("c").has_value());
+    ASSERT_TRUE(map.is_full());
+
+    ASSERT_TRUE(map.erase(h1));
+    ASSERT_EQ(map.values().size(), 1);
+    ASSERT_EQ(map.values()[0], "b");
+    ASSERT_EQ(map.handle_at(0), h2);
+
+    map.clear();
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(map.get(h2), nullptr);
+}
+
+TEST(ShmPool, test1) {
+    conq::memory::ShmPool<int, 2> pool;
+    const auto i1 = pool.allocate(1).value();
+    const auto i2 = pool.allocate(2).value();
+    ASSERT_FALSE(pool.allocate(3).has_value());
+    ASSERT_EQ(pool.at(i1), 1);
+    ASSERT_EQ(pool.at(i2), 2);
+
+    pool.deallocate(i1);
+    const auto i3 = pool.allocate(3).value();
+    ASSERT_EQ(i3, i1);
+    ASSERT_EQ(pool.at(i3), 3);
+}
+
+TEST(ShmPool, test2) {
+    using Pool = conq::memory::ShmPool<int, 16>;
+    auto shmem = conq::ShMem::create("/pool").value();
+    auto pool = shmem.allocate<Pool>();
+    ASSERT_NE(pool, nullptr);
+
+    const auto index = pool->allocate(42).value();
+    auto process = conq::Process::fork([&]() {
+        auto child = conq::ShMem::open("/pool").value().open<Pool>();
+        if (child->at(index) != 42) {
+            return 255;
+        }
+
+        const auto reply = child->allocate(7);
+        if (!reply.has_value()) {
+            return 255;
+        }
+        child->deallocate(index);
+        return static_cast<int>(reply.value());
+    }).value();
+
+    const auto reply = process.wait().value();
+    ASSERT_NE(reply, 255);
+    ASSERT_EQ(pool->at(reply), 7);
+    ASSERT_EQ(pool->allocate(0).value(), index);
+}
+
+TEST(ShmPool, test3) {
+    conq::memory::ShmPool<int, 8> pool;
+    auto worker = [&pool](int id) {
+        for (int i = 0; i < 10000; ++i) {
+            const auto index = pool.allocate(id);
+            if (!index.has_value()) {
+                continue;
+            }
+
+            EXPECT_EQ(pool.at(index.value()), id);
+            pool.deallocate(index.value());
+        }
+    };
+
+    std::thread t1(worker, 1);
+    std::thread t2(worker, 2);
+    std::thread t3(worker, 3);
+    t1.join();
+    t2.join();
+    t3.join();
+
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(pool.allocate(i).has_value());
+    }
+    ASSERT_FALSE(pool.allocate(8).has_value());
+}
+
+TEST(MemoryResource, test1) {
+    std::array<std::byte, 256> buffer{};
+    conq::memory::MonotonicArena arena(buffer);
+    std::pmr::vector<int> values(&arena);
+    values.reserve(16);
+    for (int i = 0; i < 16; ++i) {
+        values.push_back(i);
+    }
+
+    const auto p = reinterpret_cast<std::byte*>(values.data());
+    ASSERT_TRUE(p >= buffer.data() && p < buffer.data() + buffer.size());
+    ASSERT_THROW(values.reserve(1024), std::bad_alloc);
+}
+
+TEST(MemoryResource, test2) {
+    conq::memory::MonotonicArena arena(64);
+    std::pmr::vector<std::pmr::string> values(&arena);
+    for (int i = 0; i < 100; ++i) {
+        values.emplace_back(std::string(40, 'a' + i % 26));
+    }
+
+    ASSERT_EQ(std::string_view(values[27]), std::string(40, 'b'));
+}
+
+TEST(MemoryResource, test3) {
+    conq::memory::FixedPoolResource<64, 4> pool(std::pmr::null_memory_resource());
+    void* blocks[4];
+    for (auto& b: blocks) {
+        b = pool.allocate(48, 8);
+    }
+    ASSERT_EQ(pool.size(), 4);
+    ASSERT_THROW((void)pool.allocate(8, 8), std::bad_alloc);
+
+    pool.deallocate(blocks[1], 48, 8);
+    ASSERT_EQ(pool.allocate(16, 8), blocks[1]);
+}
+
+TEST(MemoryResource, test4) {
+    conq::memory::SizeClassResource<128, 32, 64, 4096> pool(std::pmr::null_memory_resource());
+    std::pmr::unordered_map<int, int> map(&pool);
+    for (int i = 0; i < 100; ++i) {
+        map[i] = i * i;
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(map[i], i * i);
+    }
+}
+
+TEST(MemoryResource, test5) {
+    conq::memory::FixedPoolResource<sizeof(std::pair<const int, int>) * 2, 32> pool;
+    std::vector<int, conq::memory::ResourceAllocator<int>> values(&pool);
+    values.push_back(1);
+    values.push_back(2);
+
+    const auto copy = values;
+    ASSERT_EQ(copy.get_allocator(), values.get_allocator());
+    ASSERT_EQ(copy[1], 2);
+}
+
+TEST(SlabAllocator, test1) {
+    using conq::memory::SlabAllocator;
+    static_assert(SlabAllocator::CLASSES == 23);
+    static_assert(SlabAllocator::class_index(1) == 0);
+    static_assert(SlabAllocator::class_index(32) == 0);
+    static_assert(SlabAllocator::class_index(33) == 1);
+    static_assert(SlabAllocator::class_index(48) == 1);
+    static_assert(SlabAllocator::class_index(49) == 2);
+    static_assert(SlabAllocator::class_index(64 * 1024) == SlabAllocator::CLASSES - 1);
+    static_assert(!SlabAllocator::class_index(64 * 1024 + 1).has_value());
+    for (std::size_t i = 0; i < SlabAllocator::CLASSES; ++i) {
+        ASSERT_EQ(SlabAllocator::class_index(SlabAllocator::class_size(i)), i);
+    }
+}
+
+TEST(SlabAllocator, test2) {
+    conq::memory::SlabAllocator slab;
+    auto p1 = slab.allocate(100);
+    auto p2 = slab.allocate(100);
+    ASSERT_NE(p1, p2);
+    std::memset(p1, 1, 100);
+    std::memset(p2, 2, 100);
+
+    const auto& stats = slab.stats(100);
+    ASSERT_EQ(stats.block_size, 128);
+    ASSERT_EQ(stats.in_use, 2);
+    ASSERT_EQ(stats.slabs, 1);
+
+    slab.deallocate(p1, 100);
+    ASSERT_EQ(slab.allocate(120), p1);
+    ASSERT_EQ(stats.allocations, 3);
+    ASSERT_EQ(stats.deallocations, 1);
+    ASSERT_EQ(stats.peak_in_use, 2);
+
+    auto big = slab.allocate(64 * 1024 + 1);
+    ASSERT_EQ(slab.oversized(), 1);
+    slab.deallocate(big, 64 * 1024 + 1);
+}
+
+TEST(SlabAllocator, test3) {
+    conq::memory::SlabAllocator slab(std::pmr::null_memory_resource());
+    ASSERT_THROW((void)slab.allocate(64), std::bad_alloc);
+
+    conq::memory::SlabAllocator reserved;
+    reserved.reserve(64 * 1024, 8);
+    ASSERT_EQ(reserved.stats(64 * 1024).slabs, 2);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 8; ++i) {
+        blocks.push_back(reserved.allocate(40000));
+    }
+    ASSERT_EQ(reserved.stats(64 * 1024).slabs, 2);
+    for (auto p: blocks) {
+        reserved.deallocate(p, 40000);
+    }
+    ASSERT_EQ(reserved.stats(40000).in_use, 0);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
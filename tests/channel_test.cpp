@@ -182,6 +182,53 @@ TEST(Encoder, test2) {
     ASSERT_EQ(data, "Hello, World!");
 }
 
+TEST(Encoder, test3) {
+    // 8 bytes: a full bucket followed by a single-byte one, including bytes >= 0x80.
+    const char message[] = {'\x01', '\xFF', '\x80', 'a', '\x7F', '\xFE', 'b', '\x90'};
+    conq::Encoder coder(std::span{message, sizeof(message)});
+
+    std::string data;
+    data.resize(sizeof(message));
+    std::size_t read{};
+    while (true) {
+        const auto encoded = coder.encode_bucket();
+        if (!encoded.has_value()) {
+            break;
+        }
+        const auto record = conq::Decoder(encoded.value())
+                .decode_bucket(std::span<char>(data.data() + read, data.size() - read));
+        ASSERT_TRUE(record.has_value());
+        read += record.value().get_length();
+    }
+
+    ASSERT_EQ(read, sizeof(message));
+    ASSERT_EQ(coder.position(), sizeof(message));
+    ASSERT_EQ(data, std::string(message, sizeof(message)));
+}
+
+TEST(Channel, test4) {
+    auto writer = conq::ChannelWriter<4>::create("/test").value();
+    auto reader = conq::ChannelReader<4>::open("/test").value();
+
+    std::string message(64, '\0');
+    for (std::size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<char>(i * 7);
+    }
+
+    // 4 buckets of 7 bytes fit, the rest is written as the reader drains.
+    std::string received(message.size(), '\0');
+    std::size_t written = writer.write(message.data(), message.size());
+    ASSERT_EQ(written, 28);
+
+    std::size_t read{};
+    while (read < message.size()) {
+        read += reader.read(std::span{received.data() + read, received.size() - read});
+        written += writer.write(std::span{message.data() + written, message.size() - written});
+    }
+
+    ASSERT_EQ(written, message.size());
+    ASSERT_EQ(received, message);
+}
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
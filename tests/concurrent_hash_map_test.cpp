@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentHashMap.h"
+#include "Rcu.h"
+
+namespace {
+    using Map = conq::ConcurrentHashMap<std::uint64_t, std::uint64_t>;
+}
+
+TEST(ConcurrentHashMap, test1) {
+    std::mt19937_64 random(7);
+    for (int i = 0; i < 10000; ++i) {
+        const auto lo = random();
+        const auto hi = random();
+        const auto tag = static_cast<std::uint8_t>(i % 4 == 0 ? 0 : lo >> (i % 8 * 8));
+        ASSERT_EQ(conq::detail::match_tags(lo, hi, tag), conq::detail::match_word(lo, tag) | conq::detail::match_word(hi, tag) << 8);
+    }
+}
+
+TEST(ConcurrentHashMap, test2) {
+    conq::RcuDomain<> domain;
+    auto reader = domain.register_reader();
+    ASSERT_TRUE(reader.has_value());
+
+    Map map(domain, 64);
+    const auto initial = map.capacity();
+    ASSERT_TRUE(map.insert(1, 10));
+    ASSERT_FALSE(map.insert(1, 11));
+    ASSERT_EQ(map.find(1), 10);
+    ASSERT_FALSE(map.insert_or_assign(1, 12));
+    ASSERT_EQ(map.find(1), 12);
+    ASSERT_FALSE(map.find(2).has_value());
+    ASSERT_TRUE(map.erase(1));
+    ASSERT_FALSE(map.erase(1));
+    ASSERT_FALSE(map.contains(1));
+    ASSERT_EQ(map.size(), 0);
+
+    // Grows through several incremental migrations.
+    for (std::uint64_t i = 0; i < 20000; ++i) {
+        ASSERT_TRUE(map.insert(i, i * 3));
+        reader->quiescent();
+    }
+    ASSERT_EQ(map.size(), 20000);
+    ASSERT_GT(map.capacity(), initial);
+    for (std::uint64_t i = 0; i < 20000; ++i) {
+        ASSERT_EQ(map.find(i), i * 3);
+    }
+    for (std::uint64_t i = 0; i < 20000; i += 2) {
+        ASSERT_TRUE(map.erase(i));
+    }
+    for (std::uint64_t i = 0; i < 20000; ++i) {
+        ASSERT_EQ(map.contains(i), i % 2 == 1);
+    }
+    reader->quiescent();
+    (void) domain.reclaim();
+}
+
+// Churn leaves tombstones; rebuilding at the same size keeps the table from growing.
+TEST(ConcurrentHashMap, test3) {
+    conq::RcuDomain<> domain;
+    auto reader = domain.register_reader();
+    Map map(domain, 256);
+    const auto initial = map.capacity();
+
+    for (std::uint64_t i = 0; i < 100000; ++i) {
+        ASSERT_TRUE(map.insert(i, i));
+        if (i >= 100) {
+            ASSERT_TRUE(map.erase(i - 100));
+        }
+        reader->quiescent();
+    }
+    ASSERT_EQ(map.size(), 100);
+    ASSERT_EQ(map.capacity(), initial);
+    for (std::uint64_t i = 100000 - 100; i < 100000; ++i) {
+        ASSERT_EQ(map.find(i), i);
+    }
+}
+
+// Readers never miss a key that is present throughout, while writers force resizes.
+TEST(ConcurrentHashMap, test4) {
+    constexpr std::uint64_t STABLE = 1000;
+    constexpr std::uint64_t PER_WRITER = 20000;
+    constexpr int WRITERS = 3;
+
+    conq::RcuDomain<> domain;
+    Map map(domain, 1024);
+    {
+        auto reader = domain.register_reader();
+        for (std::uint64_t i = 0; i < STABLE; ++i) {
+            ASSERT_TRUE(map.insert(i, i + 1));
+        }
+    }
+
+    std::atomic<int> writing{WRITERS};
+    std::atomic<long> misses{};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < WRITERS; ++w) {
+        threads.emplace_back([&, w]() {
+            auto reader = domain.register_reader();
+            const auto base = STABLE + static_cast<std::uint64_t>(w) * PER_WRITER;
+            for (std::uint64_t i = base; i < base + PER_WRITER; ++i) {
+                map.insert(i, i + 1);
+                if (i % 3 == 0) {
+                    map.insert_or_assign(i - 1, i);
+                }
+                reader->quiescent();
+            }
+            writing.fetch_sub(1);
+        });
+    }
+    for (int r = 0; r < 2; ++r) {
+        threads.emplace_back([&, r]() {
+            auto reader = domain.register_reader();
+            std::uint64_t key = r;
+            while (writing.load() != 0) {
+                for (int i = 0; i < 64; ++i, key = (key + 7) % STABLE) {
+                    const auto value = map.find(key);
+                    if (!value.has_value() || value.value() != key + 1) {
+                        misses.fetch_add(1);
+                    }
+                }
+                reader->quiescent();
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(misses.load(), 0);
+    auto reader = domain.register_reader();
+    ASSERT_EQ(map.size(), STABLE + WRITERS * PER_WRITER);
+    for (std::uint64_t i = STABLE; i < STABLE + WRITERS * PER_WRITER; ++i) {
+        const auto value = map.find(i);
+        ASSERT_TRUE(value.has_value());
+        ASSERT_TRUE(value.value() == i + 1 || value.value() == i + 2);
+    }
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
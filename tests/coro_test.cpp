@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MPMC.h"
+#include "channel/Channel.h"
+#include "coro/Async.h"
+#include "coro/EventLoop.h"
+#include "os/EventFd.h"
+#include "os/Process.h"
+
+namespace {
+    using Queue = conq::MPMCBoundedQueue<int, 64>;
+
+    conq::Task consume(conq::AsyncQueue<Queue>& queue, int count, std::vector<int>& out) {
+        for (int i = 0; i < count; ++i) {
+            out.push_back(co_await queue.pop());
+        }
+    }
+
+    conq::Task produce(conq::EventLoop& loop, conq::AsyncQueue<Queue>& queue, int count) {
+        for (int i = 0; i < count; ++i) {
+            while (!queue.try_push(i)) {
+                co_await loop.yield();
+            }
+            co_await loop.yield();
+        }
+    }
+
+    conq::Task take_one(conq::AsyncQueue<Queue>& queue, long& sum, int& done) {
+        sum += co_await queue.pop();
+        ++done;
+    }
+
+    conq::Task receive_all(conq::AsyncChannelReader<64>& reader, std::string& out, int& records) {
+        std::string buffer(16, '\0');
+        while (records < 3) {
+            const auto received = co_await reader.receive(buffer);
+            out.append(buffer.data(), received.size);
+            if (received.complete) {
+                ++records;
+            }
+        }
+    }
+}
+
+TEST(EventLoop, test1) {
+    auto loop = conq::EventLoop::create();
+    ASSERT_TRUE(loop.has_value());
+    auto event = conq::EventFd::create();
+    ASSERT_TRUE(event.has_value());
+
+    Queue queue;
+    conq::AsyncQueue<Queue> async(queue, event.value());
+    ASSERT_FALSE(loop->watch(async).has_value());
+
+    std::vector<int> first;
+    std::vector<int> second;
+    loop->spawn(consume(async, 50, first));
+    loop->spawn(consume(async, 50, second));
+    loop->spawn(produce(loop.value(), async, 100));
+    ASSERT_FALSE(loop->run().has_value());
+    ASSERT_EQ(loop->live(), 0);
+
+    ASSERT_EQ(first.size() + second.size(), 100);
+    for (std::size_t i = 1; i < first.size(); ++i) {
+        ASSERT_LT(first[i - 1], first[i]);
+    }
+}
+
+// Many parked consumers, fed by another thread; the loop sleeps in between.
+TEST(EventLoop, test2) {
+    constexpr int CONSUMERS = 2000;
+    auto loop = conq::EventLoop::create();
+    auto event = conq::EventFd::create();
+    ASSERT_TRUE(loop.has_value() && event.has_value());
+
+    Queue queue;
+    conq::AsyncQueue<Queue> async(queue, event.value());
+    ASSERT_FALSE(loop->watch(async).has_value());
+
+    long sum{};
+    int done{};
+    for (int i = 0; i < CONSUMERS; ++i) {
+        loop->spawn(take_one(async, sum, done));
+    }
+
+    std::thread producer([&]() {
+        for (int i = 1; i <= CONSUMERS; ++i) {
+            while (!async.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    ASSERT_FALSE(loop->run().has_value());
+    producer.join();
+
+    ASSERT_EQ(done, CONSUMERS);
+    ASSERT_EQ(sum, static_cast<long>(CONSUMERS) * (CONSUMERS + 1) / 2);
+}
+
+// A writer in a child process wakes the parent's loop through the inherited EventFd.
+TEST(EventLoop, test3) {
+    auto loop = conq::EventLoop::create();
+    auto event = conq::EventFd::create();
+    ASSERT_TRUE(loop.has_value() && event.has_value());
+
+    auto writer = conq::ChannelWriter<64>::create("/conq_coro_channel").value();
+    auto reader = conq::ChannelReader<64>::open("/conq_coro_channel").value();
+    conq::AsyncChannelReader<64> async(reader, event.value());
+    ASSERT_FALSE(loop->watch(async).has_value());
+
+    auto child = conq::Process::fork([&]() {
+        const std::string messages[] = {"hello", "from the", "other process"};
+        for (const auto& message: messages) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            std::size_t written{};
+            while (written < message.size()) {
+                written += writer.write(std::span(message).subspan(written));
+            }
+            event->notify();
+        }
+        return 0;
+    });
+    ASSERT_TRUE(child.has_value());
+
+    std::string out;
+    int records{};
+    loop->spawn(receive_all(async, out, records));
+    ASSERT_FALSE(loop->run().has_value());
+    ASSERT_EQ(child->wait(), 0);
+    ASSERT_EQ(out, "hellofrom theother process");
+    ASSERT_EQ(records, 3);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
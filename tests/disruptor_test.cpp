@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Disruptor.h"
+
+namespace {
+    struct Order {
+        long raw{};
+        long decoded{};
+        long risk{};
+        bool routed{};
+    };
+
+    template<typename Ring>
+    void wait_until(const Ring& ring, const conq::Sequence& sequence) {
+        while (sequence.get() < ring.cursor()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+TEST(Disruptor, test1) {
+    auto ring = std::make_unique<conq::RingBuffer<long, 8>>();
+    conq::Sequence consumer;
+    ring->add_gating(consumer);
+
+    for (long i = 0; i < 8; ++i) {
+        const auto sequence = ring->try_next();
+        ASSERT_EQ(sequence, i);
+        (*ring)[i] = i * 10;
+        ring->publish(i);
+    }
+    ASSERT_FALSE(ring->try_next().has_value());
+    ASSERT_EQ(ring->cursor(), 7);
+
+    consumer.set(3);
+    ASSERT_EQ(ring->try_next(4), 11);
+    ASSERT_FALSE(ring->try_next().has_value());
+    ASSERT_EQ((*ring)[8], 0);
+}
+
+// decode -> risk -> route, each stage working on the event in place.
+TEST(Disruptor, test2) {
+    constexpr long EVENTS = 100000;
+    using Ring = conq::RingBuffer<Order, 256, conq::Producers::Single, conq::BlockingWait>;
+    auto ring = std::make_unique<Ring>();
+
+    conq::BatchProcessor decode(*ring, {}, [](Order& order, std::int64_t, bool) {
+        order.decoded = order.raw * 2;
+    });
+    std::atomic<long> unordered{};
+    conq::BatchProcessor risk(*ring, {&decode.sequence()}, [&](Order& order, std::int64_t, bool) {
+        if (order.decoded != order.raw * 2) {
+            unordered.fetch_add(1);
+        }
+        order.risk = order.decoded + 1;
+    });
+    long routed = 0;
+    long batches = 0;
+    conq::BatchProcessor route(*ring, {&risk.sequence()}, [&](Order& order, std::int64_t, bool end_of_batch) {
+        if (order.risk != order.raw * 2 + 1) {
+            unordered.fetch_add(1);
+        }
+        order.routed = true;
+        routed += order.risk;
+        batches += end_of_batch;
+    });
+    ring->add_gating(route.sequence());
+
+    std::vector<std::thread> stages;
+    stages.emplace_back([&]() { decode.run(); });
+    stages.emplace_back([&]() { risk.run(); });
+    stages.emplace_back([&]() { route.run(); });
+
+    for (long i = 0; i < EVENTS; ++i) {
+        ring->publish_event([i](Order& order, std::int64_t) {
+            order = Order{i};
+        });
+    }
+    wait_until(*ring, route.sequence());
+    decode.halt();
+    risk.halt();
+    route.halt();
+    for (auto& stage: stages) {
+        stage.join();
+    }
+
+    ASSERT_EQ(unordered.load(), 0);
+    ASSERT_EQ(routed, EVENTS * EVENTS);
+    ASSERT_GE(batches, 1);
+    ASSERT_LE(batches, EVENTS);
+}
+
+// Several producers, and two independent consumers of the same events.
+TEST(Disruptor, test3) {
+    constexpr long PER_PRODUCER = 50000;
+    constexpr int PRODUCERS = 3;
+    using Ring = conq::RingBuffer<long, 128, conq::Producers::Multi, conq::YieldingWait>;
+    auto ring = std::make_unique<Ring>();
+
+    std::vector<int> seen(PRODUCERS * PER_PRODUCER);
+    long sum = 0;
+    conq::BatchProcessor counter(*ring, {}, [&](long& value, std::int64_t, bool) {
+        ++seen[static_cast<std::size_t>(value)];
+    });
+    conq::BatchProcessor adder(*ring, {}, [&](long& value, std::int64_t, bool) {
+        sum += value;
+    });
+    ring->add_gating(counter.sequence());
+    ring->add_gating(adder.sequence());
+
+    std::vector<std::thread> threads;
+    threads.emplace_back([&]() { counter.run(); });
+    threads.emplace_back([&]() { adder.run(); });
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p]() {
+            // Batches of two claimed at once.
+            for (long i = 0; i < PER_PRODUCER; i += 2) {
+                const auto high = ring->next(2);
+                (*ring)[high - 1] = p * PER_PRODUCER + i;
+                (*ring)[high] = p * PER_PRODUCER + i + 1;
+                ring->publish(high - 1, high);
+            }
+        });
+    }
+    for (auto& producer: producers) {
+        producer.join();
+    }
+    wait_until(*ring, counter.sequence());
+    wait_until(*ring, adder.sequence());
+    counter.halt();
+    adder.halt();
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    for (const auto count: seen) {
+        ASSERT_EQ(count, 1);
+    }
+    const long total = PRODUCERS * PER_PRODUCER;
+    ASSERT_EQ(sum, total * (total - 1) / 2);
+}
+
+TEST(Disruptor, test4) {
+    auto ring = std::make_unique<conq::RingBuffer<int, 16, conq::Producers::Single, conq::BusySpinWait>>();
+    int handled = 0;
+    conq::BatchProcessor idle(*ring, {}, [&](int&, std::int64_t, bool) { ++handled; });
+    ring->add_gating(idle.sequence());
+
+    std::thread thread([&]() { ASSERT_EQ(idle.run(), 0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    idle.halt();
+    thread.join();
+    ASSERT_EQ(handled, 0);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
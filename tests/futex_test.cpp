@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "channel/Channel.h"
+#include "os/Futex.h"
+#include "os/Process.h"
+#include "os/ShMem.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    struct PingPong {
+        conq::FutexSemaphore ping{};
+        conq::FutexSemaphore pong{};
+    };
+
+    struct Guarded {
+        conq::FutexMutex mutex{};
+        long counter{};
+    };
+
+    struct Handshake {
+        conq::FutexEvent created{};
+        conq::FutexEvent consumed{};
+    };
+}
+
+TEST(FutexSemaphore, test1) {
+    conq::FutexSemaphore sem(1);
+    ASSERT_TRUE(sem.try_wait());
+    ASSERT_FALSE(sem.try_wait());
+
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_FALSE(sem.wait_for(20ms));
+    ASSERT_GE(std::chrono::steady_clock::now() - start, 20ms);
+
+    sem.post();
+    sem.post();
+    ASSERT_EQ(sem.value(), 2);
+    ASSERT_TRUE(sem.wait_for(1s));
+    sem.wait();
+    ASSERT_EQ(sem.value(), 0);
+}
+
+TEST(FutexSemaphore, test2) {
+    constexpr int ROUNDS = 1000;
+    auto shmem = conq::ShMem::create("/conq_futex_ping").value();
+    auto shared = shmem.allocate<PingPong>();
+
+    auto child = conq::Process::fork([shared]() {
+        for (int i = 0; i < ROUNDS; ++i) {
+            shared->ping.wait();
+            shared->pong.post();
+        }
+        return 0;
+    });
+    ASSERT_TRUE(child.has_value());
+
+    for (int i = 0; i < ROUNDS; ++i) {
+        shared->ping.post();
+        ASSERT_TRUE(shared->pong.wait_for(10s));
+    }
+    ASSERT_EQ(child->wait(), 0);
+}
+
+TEST(FutexMutex, test1) {
+    constexpr int ROUNDS = 20000;
+    auto shmem = conq::ShMem::create("/conq_futex_mutex").value();
+    auto shared = shmem.allocate<Guarded>();
+
+    auto increment = [shared]() {
+        for (int i = 0; i < ROUNDS; ++i) {
+            std::lock_guard lock(shared->mutex);
+            shared->counter = shared->counter + 1;
+        }
+        return 0;
+    };
+    auto first = conq::Process::fork(increment);
+    auto second = conq::Process::fork(increment);
+    ASSERT_TRUE(first.has_value());
+    ASSERT_TRUE(second.has_value());
+    ASSERT_EQ(first->wait(), 0);
+    ASSERT_EQ(second->wait(), 0);
+    ASSERT_EQ(shared->counter, 2 * ROUNDS);
+
+    ASSERT_TRUE(shared->mutex.try_lock());
+    ASSERT_FALSE(shared->mutex.try_lock_for(10ms));
+    shared->mutex.unlock();
+    ASSERT_TRUE(shared->mutex.try_lock_for(10ms));
+    shared->mutex.unlock();
+}
+
+TEST(FutexEvent, test1) {
+    conq::FutexEvent event;
+    ASSERT_FALSE(event.try_wait());
+    ASSERT_FALSE(event.wait_for(5ms));
+
+    std::atomic<int> woken{};
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&]() {
+            event.wait();
+            woken.fetch_add(1);
+        });
+    }
+    event.set();
+    for (auto& waiter: waiters) {
+        waiter.join();
+    }
+    ASSERT_EQ(woken.load(), 3);
+    ASSERT_TRUE(event.try_wait());
+
+    event.reset();
+    ASSERT_FALSE(event.try_wait());
+}
+
+// Channel handshake without named semaphores: both events live in one segment.
+TEST(FutexEvent, test2) {
+    auto shmem = conq::ShMem::create("/conq_futex_handshake").value();
+    auto shared = shmem.allocate<Handshake>();
+
+    auto producer = conq::Process::fork([shared]() {
+        auto writer = conq::ChannelWriter<4>::create("/conq_futex_channel").value();
+        writer.write("test", 4);
+        shared->created.set();
+        return shared->consumed.wait_for(10s) ? 0 : 1;
+    });
+    ASSERT_TRUE(producer.has_value());
+
+    auto consumer = conq::Process::fork([shared]() {
+        if (!shared->created.wait_for(10s)) {
+            return 1;
+        }
+
+        auto reader = conq::ChannelReader<4>::open("/conq_futex_channel").value();
+        std::string data(4, '\0');
+        reader.read(data);
+        shared->consumed.set();
+        return data == "test" ? 0 : 1;
+    });
+    ASSERT_TRUE(consumer.has_value());
+
+    ASSERT_EQ(producer->wait(), 0);
+    ASSERT_EQ(consumer->wait(), 0);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
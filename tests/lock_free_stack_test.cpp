@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "LockFreeStack.h"
+#include "QueueStats.h"
 
 TEST(LockFreeTest, test1) {
     conq::LockFreeStack<int> stack;
@@ -108,6 +109,21 @@ TEST(LockFreeTest, test3) {
 }
 
 
+TEST(LockFreeTest, test4) {
+    conq::LockFreeStack<int, conq::QueueStats<>> stack;
+    stack.push(1);
+    stack.push(2);
+    ASSERT_EQ(stack.pop().value(), 2);
+    ASSERT_EQ(stack.pop().value(), 1);
+    ASSERT_FALSE(stack.pop().has_value());
+
+    const auto stats = stack.stats().snapshot();
+    ASSERT_EQ(stats.push, 2);
+    ASSERT_EQ(stats.pop, 2);
+    ASSERT_EQ(stats.empty, 1);
+    ASSERT_EQ(stats.cas_retries, 0);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
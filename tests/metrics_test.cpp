@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "metrics/Histogram.h"
+#include "metrics/Registry.h"
+#include "os/ShMem.h"
+#include "os/Process.h"
+
+TEST(Histogram, test1) {
+    conq::metrics::Histogram histogram;
+    for (std::uint64_t i = 1; i <= 10000; ++i) {
+        histogram.record(i);
+    }
+
+    const auto snapshot = histogram.snapshot();
+    ASSERT_EQ(snapshot.count(), 10000);
+    ASSERT_EQ(snapshot.min(), 1);
+    ASSERT_EQ(snapshot.max(), 10000);
+    ASSERT_DOUBLE_EQ(snapshot.mean(), 5000.5);
+
+    // Within the 1/64 relative error of the bucket layout.
+    ASSERT_NEAR(static_cast<double>(snapshot.percentile(0.5)), 5000, 5000 / 64.0);
+    ASSERT_NEAR(static_cast<double>(snapshot.percentile(0.99)), 9900, 9900 / 64.0);
+    ASSERT_EQ(snapshot.percentile(1.0), 10000);
+
+    histogram.reset();
+    ASSERT_EQ(histogram.snapshot().count(), 0);
+    ASSERT_EQ(histogram.snapshot().percentile(0.5), 0);
+}
+
+TEST(Histogram, test2) {
+    conq::metrics::HistogramSnapshot small;
+    for (std::uint64_t i = 0; i < 128; ++i) {
+        small.record(i);
+    }
+    // Values below the sub-bucket count are exact.
+    ASSERT_EQ(small.percentile(0.5), 63);
+
+    conq::metrics::HistogramSnapshot large;
+    large.record(UINT64_MAX);
+    large.merge(small);
+    ASSERT_EQ(large.count(), 129);
+    ASSERT_EQ(large.max(), UINT64_MAX);
+    ASSERT_EQ(large.percentile(1.0), UINT64_MAX);
+    ASSERT_EQ(large.min(), 0);
+}
+
+TEST(Histogram, test3) {
+    conq::metrics::Histogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t] {
+            for (std::uint64_t i = 0; i < 10000; ++i) {
+                histogram.record(static_cast<std::uint64_t>(t) * 1000 + i % 1000);
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    const auto snapshot = histogram.snapshot();
+    ASSERT_EQ(snapshot.count(), 40000);
+    ASSERT_EQ(snapshot.min(), 0);
+    ASSERT_EQ(snapshot.max(), 3999);
+}
+
+TEST(Registry, test1) {
+    auto registry = std::make_unique<conq::metrics::Registry<2, 2, 1>>();
+
+    auto pushes = registry->counter("queue.push");
+    ASSERT_NE(pushes, nullptr);
+    ASSERT_EQ(registry->counter("queue.push"), pushes);
+    ASSERT_NE(registry->counter("queue.pop"), nullptr);
+    ASSERT_EQ(registry->counter("queue.full"), nullptr);
+    ASSERT_EQ(registry->counter(std::string(64, 'x')), nullptr);
+
+    pushes->add();
+    pushes->add(2);
+    registry->gauge("queue.depth")->set(-3);
+    registry->histogram("queue.latency")->record(100);
+
+    std::ostringstream os;
+    os << *registry;
+    ASSERT_NE(os.str().find("queue.push 3\n"), std::string::npos);
+    ASSERT_NE(os.str().find("queue.pop 0\n"), std::string::npos);
+    ASSERT_NE(os.str().find("queue.depth -3\n"), std::string::npos);
+    ASSERT_NE(os.str().find("queue.latency count=1"), std::string::npos);
+}
+
+TEST(Registry, test2) {
+    using Metrics = conq::metrics::Registry<8, 8, 2>;
+
+    auto shmem = conq::ShMem::create("/metrics").value();
+    auto registry = shmem.allocate<Metrics>();
+    ASSERT_NE(registry, nullptr);
+
+    auto process = conq::Process::fork([]() {
+        auto child = conq::ShMem::open("/metrics").value().open<Metrics>();
+        auto requests = child->counter("requests");
+        auto latency = child->histogram("latency");
+        for (std::uint64_t i = 0; i < 1000; ++i) {
+            requests->add();
+            latency->record(i);
+        }
+        return 0;
+    });
+    ASSERT_EQ(process.value().wait().value(), 0);
+
+    std::size_t seen = 0;
+    registry->visit([&](std::string_view name, const auto& metric) {
+        using M = std::remove_cvref_t<decltype(metric)>;
+        if constexpr (std::is_same_v<M, conq::metrics::Counter>) {
+            ASSERT_EQ(name, "requests");
+            ASSERT_EQ(metric.value(), 1000);
+            ++seen;
+        } else if constexpr (std::is_same_v<M, conq::metrics::Histogram>) {
+            ASSERT_EQ(name, "latency");
+            ASSERT_EQ(metric.snapshot().count(), 1000);
+            ASSERT_EQ(metric.snapshot().max(), 999);
+            ++seen;
+        }
+    });
+    ASSERT_EQ(seen, 2);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
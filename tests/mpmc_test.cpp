@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "MPMC.h"
+#include "QueueStats.h"
 
 TEST(MPMCBoundedQ, test1) {
     conq::MPMCBoundedQueue<int, 4> queue;
@@ -156,6 +157,119 @@ TEST(MPMC, test4) {
     }
 }
 
+TEST(MPMC, test5) {
+    // NoStats takes no space: head, tail and four slots, one cache line each.
+    static_assert(sizeof(conq::MPMCBoundedQueue<int, 4>) == 6 * conq::CACHE_LINE_SIZE);
+
+    using Queue = conq::MPMCBoundedQueue<int, 4, conq::QueueStats<>>;
+    auto queue = std::make_unique<Queue>();
+    ASSERT_FALSE(queue->try_pop().has_value());
+
+    auto producer_fn = [](Queue &queue) {
+        for (int i = 0; i < 1000; ++i) {
+            while (!queue.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    auto consumer_fn = [](Queue &queue) {
+        for (int i = 0; i < 1000; ++i) {
+            while (!queue.try_pop().has_value()) {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    std::thread producer1(producer_fn, std::ref(*queue));
+    std::thread producer2(producer_fn, std::ref(*queue));
+    std::thread consumer1(consumer_fn, std::ref(*queue));
+    std::thread consumer2(consumer_fn, std::ref(*queue));
+    producer1.join();
+    producer2.join();
+    consumer1.join();
+    consumer2.join();
+
+    const auto stats = queue->stats().snapshot();
+    ASSERT_EQ(stats.push, 2000);
+    ASSERT_EQ(stats.pop, 2000);
+    ASSERT_GE(stats.empty, 1);
+    ASSERT_GE(stats.high_water, 1);
+    ASSERT_LE(stats.high_water, 4);
+}
+
+TEST(PriorityMPMC, test1) {
+    conq::PriorityMPMCQueue<int, 4, 3> queue;
+    ASSERT_TRUE(queue.empty());
+    ASSERT_FALSE(queue.try_pop().has_value());
+    ASSERT_FALSE(queue.try_push(3, 0));
+
+    ASSERT_TRUE(queue.try_push(2, 20));
+    ASSERT_TRUE(queue.try_push(2, 21));
+    ASSERT_TRUE(queue.try_push(1, 10));
+    ASSERT_TRUE(queue.try_push(0, 0));
+    ASSERT_TRUE(queue.try_push(2, 22));
+    ASSERT_TRUE(queue.try_push(2, 23));
+    ASSERT_FALSE(queue.try_push(2, 24));
+    ASSERT_TRUE(queue.try_push(0, 1));
+
+    std::size_t priority{};
+    for (const auto& [value, level]: std::vector<std::pair<int, std::size_t>>{{0, 0}, {1, 0}, {10, 1}, {20, 2}, {21, 2}, {22, 2}}) {
+        const auto popped = queue.try_pop(priority);
+        ASSERT_TRUE(popped.has_value());
+        ASSERT_EQ(popped.value(), value);
+        ASSERT_EQ(priority, level);
+    }
+
+    // High-priority work overtakes what is still queued below it.
+    ASSERT_TRUE(queue.try_push(1, 11));
+    ASSERT_EQ(queue.try_pop(), 11);
+    ASSERT_EQ(queue.try_pop(), 23);
+    ASSERT_FALSE(queue.try_pop().has_value());
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST(PriorityMPMC, test2) {
+    constexpr int PER_PRODUCER = 20000;
+    conq::PriorityMPMCQueue<int, 64, 4, conq::QueueStats<>> queue;
+    std::atomic<int> popped{};
+    std::atomic<long> sum{};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 1; i <= PER_PRODUCER; ++i) {
+                while (!queue.try_push(static_cast<std::size_t>((i + p) % 4), i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&]() {
+            while (popped.load() < 2 * PER_PRODUCER) {
+                if (const auto value = queue.try_pop(); value.has_value()) {
+                    sum.fetch_add(value.value());
+                    popped.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(sum.load(), 2L * PER_PRODUCER * (PER_PRODUCER + 1) / 2);
+    ASSERT_TRUE(queue.empty());
+    std::uint64_t pushed{};
+    for (std::size_t level = 0; level < queue.levels(); ++level) {
+        pushed += queue.stats(level).snapshot().push;
+    }
+    ASSERT_EQ(pushed, 2 * PER_PRODUCER);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
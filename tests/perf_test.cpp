@@ -1,6 +1,46 @@
 #include <gtest/gtest.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <vector>
 
 #include "os/perf/Perf.h"
+#include "os/perf/PerfSet.h"
+#include "os/perf/Sampler.h"
+
+namespace {
+    // Anonymous mapping, so every touched page is a fresh page fault regardless of malloc state.
+    class Pages final {
+    public:
+        explicit Pages(std::size_t count) :
+                m_size(count * 4096),
+                m_data(static_cast<char*>(mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))) {}
+
+        ~Pages() {
+            munmap(m_data, m_size);
+        }
+
+        void touch(std::size_t page) {
+            m_data[page * 4096] = 1;
+        }
+
+    private:
+        std::size_t m_size;
+        char* m_data;
+    };
+}
+
+// noipa: an IPA clone (.constprop, .isra) is not exported, so samples in it would go unnamed.
+[[gnu::noipa]]
+std::uint64_t sampler_hot_loop(std::uint64_t iterations) {
+    volatile std::uint64_t acc = 0;
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+        acc = acc + i * i;
+    }
+    return acc;
+}
 
 TEST(RCU, test1) {
     auto perf = conq::perf::Perf::open();
@@ -10,7 +50,207 @@ TEST(RCU, test1) {
     std::cout << count << std::endl;
 }
 
+TEST(Perf, test1) {
+    constexpr conq::perf::Event events[] = {
+            conq::perf::Event::PageFaults,
+            conq::perf::Event::ContextSwitches,
+    };
+    auto perf = conq::perf::Perf::open(events);
+    ASSERT_TRUE(perf.has_value());
+    ASSERT_TRUE(perf->has(conq::perf::Event::PageFaults));
+    ASSERT_FALSE(perf->has(conq::perf::Event::CpuCycles));
+
+    perf->start();
+    Pages pages(64);
+    for (std::size_t i = 0; i < 64; ++i) {
+        pages.touch(i);
+    }
+    perf->stop();
+
+    const auto data = perf->read();
+    ASSERT_TRUE(data.get(conq::perf::Event::PageFaults).has_value());
+    ASSERT_GT(data.get(conq::perf::Event::PageFaults).value(), 0);
+    ASSERT_TRUE(data.get(conq::perf::Event::ContextSwitches).has_value());
+    ASSERT_FALSE(data.cpu_cycles().has_value());
+}
+
+TEST(Perf, test2) {
+    constexpr conq::perf::Event events[] = {
+            conq::perf::Event::CpuCycles,
+            conq::perf::Event::PageFaults,
+    };
+    auto perf = conq::perf::Perf::open(events);
+    ASSERT_TRUE(perf.has_value());
+
+    perf->start();
+    conq::perf::PerfData total;
+    Pages pages(64);
+    for (std::size_t i = 0; i < 64; ++i) {
+        conq::perf::Perf::Scope scope(perf.value(), total);
+        pages.touch(i);
+    }
+    perf->stop();
+
+    ASSERT_TRUE(total.get(conq::perf::Event::PageFaults).has_value());
+    ASSERT_GT(total.get(conq::perf::Event::PageFaults).value(), 0);
+    if (perf->has(conq::perf::Event::CpuCycles)) {
+        ASSERT_GT(total.cpu_cycles().value(), 0);
+    }
+}
+
+TEST(Perf, test3) {
+    constexpr conq::perf::Event events[] = {
+            conq::perf::Event::PageFaults,
+    };
+
+    std::atomic<int> ready = 0;
+    std::atomic<bool> go = false;
+    pid_t tids[2]{};
+    auto worker = [&](int id, std::size_t count) {
+        tids[id] = gettid();
+        ready.fetch_add(1, std::memory_order_release);
+        go.wait(false, std::memory_order_acquire);
+
+        Pages pages(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            pages.touch(i);
+        }
+    };
+
+    std::thread producer(worker, 0, 64);
+    std::thread consumer(worker, 1, 128);
+    while (ready.load(std::memory_order_acquire) != 2) {
+        std::this_thread::yield();
+    }
+
+    auto set = conq::perf::PerfSet::threads(tids, events);
+    ASSERT_TRUE(set.has_value());
+    set->start();
+    go.store(true, std::memory_order_release);
+    go.notify_all();
+    producer.join();
+    consumer.join();
+    set->stop();
+
+    const auto each = set->read_each();
+    ASSERT_EQ(each.size(), 2);
+    conq::perf::PerfReport report;
+    report.add("producer", each[0]);
+    report.add("consumer", each[1]);
+
+    const auto faults = conq::perf::Event::PageFaults;
+    ASSERT_GE(each[0].get(faults).value(), 64);
+    ASSERT_GE(each[1].get(faults).value(), 128);
+    ASSERT_EQ(report.total().get(faults).value(), set->read().get(faults).value());
+}
+
+TEST(Perf, test4) {
+    constexpr conq::perf::Event events[] = {
+            conq::perf::Event::PageFaults,
+    };
+    auto perf = conq::perf::Perf::open(conq::perf::Target::inherited(), events);
+    ASSERT_TRUE(perf.has_value());
+
+    perf->start();
+    std::thread child([] {
+        Pages pages(64);
+        for (std::size_t i = 0; i < 64; ++i) {
+            pages.touch(i);
+        }
+    });
+    child.join();
+    perf->stop();
+
+    ASSERT_GE(perf->read().get(conq::perf::Event::PageFaults).value(), 64);
+}
+
+// Hardware-only group: Scope stays on rdpmc wherever the PMU and rdpmc are available.
+TEST(Perf, test5) {
+    auto perf = conq::perf::Perf::open(conq::perf::HARDWARE_EVENTS);
+    if (!perf.has_value() || !perf->has(conq::perf::Event::CpuCycles)) {
+        return;
+    }
+
+    perf->start();
+    std::ifstream rdpmc("/sys/bus/event_source/devices/cpu/rdpmc");
+    int allowed = 0;
+    if (rdpmc >> allowed && allowed != 0) {
+        ASSERT_TRUE(perf->userspace_readable());
+    }
+
+    conq::perf::PerfData total;
+    std::uint64_t sink = 0;
+    for (int i = 0; i < 64; ++i) {
+        conq::perf::Perf::Scope scope(perf.value(), total);
+        sink += sampler_hot_loop(1000);
+    }
+    perf->stop();
+
+    ASSERT_GT(sink, 0);
+    // A delta mixing scaled and raw readings could wrap around.
+    ASSERT_GT(total.cpu_cycles().value(), 0);
+    ASSERT_LT(total.cpu_cycles().value(), std::uint64_t{1} << 40);
+    ASSERT_LE(total.cpu_cycles().value(), perf->read().cpu_cycles().value());
+}
+
+TEST(Sampler, test1) {
+    auto sampler = conq::perf::Sampler::open(conq::perf::Target::calling_thread(), 4000);
+    ASSERT_TRUE(sampler.has_value());
+
+    sampler->start();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while (std::chrono::steady_clock::now() < deadline) {
+        sampler_hot_loop(100000);
+        sampler->drain();
+    }
+    sampler->stop();
+    sampler->drain();
+
+    const auto report = sampler->report(5);
+    ASSERT_GT(report.samples(), 0);
+    ASSERT_FALSE(report.spots().empty());
+
+    const auto hot = std::ranges::find_if(report.spots(), [](const conq::perf::HotSpot& spot) {
+        return spot.symbol.starts_with("sampler_hot_loop");
+    });
+    ASSERT_NE(hot, report.spots().end());
+    ASSERT_GT(hot->self, 0);
+}
+
+TEST(PerfData, test1) {
+    conq::perf::PerfData data;
+    ASSERT_FALSE(data.ipc().has_value());
+
+    data.set(conq::perf::Event::CpuCycles, 1000);
+    data.set(conq::perf::Event::Instructions, 2000);
+    data.set(conq::perf::Event::CacheReferences, 100);
+    data.set(conq::perf::Event::CacheMisses, 25);
+    data.set(conq::perf::Event::BranchMisses, 4);
+
+    ASSERT_DOUBLE_EQ(data.ipc().value(), 2.0);
+    ASSERT_DOUBLE_EQ(data.cache_miss_rate().value(), 0.25);
+    ASSERT_DOUBLE_EQ(data.branch_mpki().value(), 2.0);
+    ASSERT_FALSE(data.l1d_mpki().has_value());
+}
+
+TEST(PerfData, test2) {
+    conq::perf::PerfData begin;
+    begin.set(conq::perf::Event::CpuCycles, 100);
+    begin.set(conq::perf::Event::PageFaults, 1);
+    conq::perf::PerfData end;
+    end.set(conq::perf::Event::CpuCycles, 250);
+
+    const auto delta = end - begin;
+    ASSERT_EQ(delta.cpu_cycles().value(), 150);
+    ASSERT_FALSE(delta.has(conq::perf::Event::PageFaults));
+
+    conq::perf::PerfData total;
+    total += delta;
+    total += delta;
+    ASSERT_EQ(total.cpu_cycles().value(), 300);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <sched.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "os/Placement.h"
+#include "os/Process.h"
+#include "os/Topology.h"
+
+namespace {
+    void write_file(const std::filesystem::path& path, const std::string& content) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path) << content << '\n';
+    }
+
+    // Two sockets with one node each; two SMT cores per socket sharing an L3.
+    std::filesystem::path fake_sysfs() {
+        const auto root = std::filesystem::temp_directory_path() / "conq_sysfs";
+        std::filesystem::remove_all(root);
+        write_file(root / "cpu" / "online", "0-7");
+        for (int cpu = 0; cpu < 8; ++cpu) {
+            const auto dir = root / "cpu" / ("cpu" + std::to_string(cpu));
+            const auto package = cpu / 4;
+            write_file(dir / "topology" / "core_id", std::to_string((cpu % 4) / 2));
+            write_file(dir / "topology" / "physical_package_id", std::to_string(package));
+            write_file(dir / "cache" / "index3" / "level", "3");
+            write_file(dir / "cache" / "index3" / "shared_cpu_list", package == 0 ? "0-3" : "4-7");
+        }
+        write_file(root / "node" / "node0" / "cpulist", "0-3");
+        write_file(root / "node" / "node1" / "cpulist", "4-7");
+        write_file(root / "node" / "online", "0-1");
+        return root;
+    }
+}
+
+TEST(Topology, test1) {
+    ASSERT_EQ(conq::parse_cpu_list("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    ASSERT_EQ(conq::parse_cpu_list("5"), (std::vector<int>{5}));
+    ASSERT_TRUE(conq::parse_cpu_list("").empty());
+}
+
+TEST(Topology, test2) {
+    const auto root = fake_sysfs();
+    const auto topology = conq::Topology::query(root);
+    ASSERT_TRUE(topology.has_value());
+
+    ASSERT_EQ(topology->cpus().size(), 8);
+    ASSERT_EQ(topology->cores(), 4);
+    ASSERT_EQ(topology->sockets(), 2);
+    ASSERT_EQ(topology->nodes(), (std::vector<int>{0, 1}));
+    ASSERT_EQ(topology->node_cpus(1), (std::vector<int>{4, 5, 6, 7}));
+    ASSERT_EQ(topology->smt_siblings(2), (std::vector<int>{2, 3}));
+    ASSERT_EQ(topology->l3_domain(5), (std::vector<int>{4, 5, 6, 7}));
+
+    ASSERT_EQ(topology->relation(1, 1), conq::CpuRelation::SameCpu);
+    ASSERT_EQ(topology->relation(0, 1), conq::CpuRelation::SmtSibling);
+    ASSERT_EQ(topology->relation(0, 2), conq::CpuRelation::SharedL3);
+    ASSERT_EQ(topology->relation(3, 4), conq::CpuRelation::CrossSocket);
+    ASSERT_EQ(topology->relation(0, 42), conq::CpuRelation::CrossSocket);
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(Topology, test3) {
+    const auto topology = conq::Topology::query();
+    ASSERT_TRUE(topology.has_value());
+    ASSERT_FALSE(topology->cpus().empty());
+    ASSERT_GE(topology->cores(), 1);
+    ASSERT_NE(topology->cpu(topology->cpus().front().id), nullptr);
+}
+
+TEST(Placement, test1) {
+    auto thread = conq::spawn_thread(conq::Placement::on(0), [] {
+        ASSERT_EQ(sched_getcpu(), 0);
+    });
+    ASSERT_TRUE(thread.has_value());
+    thread->join();
+
+    auto invalid = conq::spawn_thread(conq::Placement::on(-1), [] {
+        FAIL() << "must not run";
+    });
+    ASSERT_FALSE(invalid.has_value());
+    ASSERT_EQ(invalid.error().code(), EINVAL);
+}
+
+TEST(Placement, test2) {
+    conq::Placement placement{{0}};
+    placement.local_memory = true;
+
+    auto process = conq::Process::fork(placement, [] {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        sched_getaffinity(0, sizeof(set), &set);
+        return CPU_COUNT(&set) == 1 && CPU_ISSET(0, &set) ? 0 : 1;
+    });
+    const auto status = process.value().wait();
+    // set_mempolicy can be filtered in containers; the child then reports it.
+    ASSERT_TRUE(status.value() == 0 || status.value() == conq::Process::PLACEMENT_FAILED);
+
+    auto failed = conq::Process::fork(conq::Placement::on(CPU_SETSIZE), [] {
+        return 0;
+    });
+    ASSERT_EQ(failed.value().wait().value(), conq::Process::PLACEMENT_FAILED);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
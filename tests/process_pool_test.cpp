@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "os/Process.h"
+#include "os/ProcessPool.h"
+
+namespace {
+    using Pool = conq::ProcessPool<int, long>;
+
+    long square(const int& value) {
+        if (value < 0) {
+            raise(SIGKILL);
+        }
+        return static_cast<long>(value) * value;
+    }
+
+    std::vector<conq::Completion<long>> collect(Pool& pool, std::size_t count) {
+        std::vector<conq::Completion<long>> completions;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (completions.size() < count && std::chrono::steady_clock::now() < deadline) {
+            auto polled = pool.poll();
+            EXPECT_TRUE(polled.has_value());
+            completions.insert(completions.end(), polled->begin(), polled->end());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return completions;
+    }
+}
+
+TEST(Process, test1) {
+    auto sleeper = conq::Process::fork([]() {
+        pause();
+        return 0;
+    });
+    ASSERT_TRUE(sleeper.has_value());
+
+    const auto running = sleeper->try_wait();
+    ASSERT_TRUE(running.has_value());
+    ASSERT_FALSE(running->has_value());
+
+    ASSERT_FALSE(sleeper->kill(SIGTERM).has_value());
+    std::optional<int> status;
+    while (!status.has_value()) {
+        const auto polled = sleeper->try_wait();
+        ASSERT_TRUE(polled.has_value());
+        status = polled.value();
+    }
+    ASSERT_EQ(status.value(), 128 + SIGTERM);
+
+    auto exiting = conq::Process::fork([]() { return 7; });
+    ASSERT_TRUE(exiting.has_value());
+    ASSERT_EQ(exiting->wait(), 7);
+}
+
+TEST(ProcessPool, test1) {
+    auto pool = Pool::create(3, square);
+    ASSERT_TRUE(pool.has_value());
+    ASSERT_EQ(pool->workers(), 3);
+
+    std::map<std::uint64_t, int> submitted;
+    for (int i = 0; i < 100; ++i) {
+        const auto id = pool->submit(i);
+        ASSERT_TRUE(id.has_value());
+        submitted[id.value()] = i;
+    }
+
+    const auto completions = collect(pool.value(), submitted.size());
+    ASSERT_EQ(completions.size(), submitted.size());
+    for (const auto& completion: completions) {
+        ASSERT_EQ(completion.status, conq::TaskStatus::Done);
+        const auto value = submitted.at(completion.id);
+        ASSERT_EQ(completion.result, static_cast<long>(value) * value);
+    }
+    ASSERT_EQ(pool->respawns(), 0);
+}
+
+TEST(ProcessPool, test2) {
+    auto pool = Pool::create(2, square);
+    ASSERT_TRUE(pool.has_value());
+    const auto before = pool->pids();
+
+    const auto poisoned = pool->submit(-1);
+    ASSERT_TRUE(poisoned.has_value());
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(pool->submit(i).has_value());
+    }
+
+    const auto completions = collect(pool.value(), 11);
+    ASSERT_EQ(completions.size(), 11);
+    std::size_t crashed = 0;
+    for (const auto& completion: completions) {
+        if (completion.status == conq::TaskStatus::Crashed) {
+            ASSERT_EQ(completion.id, poisoned.value());
+            ++crashed;
+        }
+    }
+    ASSERT_EQ(crashed, 1);
+    ASSERT_EQ(pool->respawns(), 1);
+    ASSERT_EQ(pool->workers(), 2);
+    ASSERT_NE(pool->pids(), before);
+
+    // The replacement takes work like any other worker.
+    ASSERT_TRUE(pool->submit(12).has_value());
+    const auto after = collect(pool.value(), 1);
+    ASSERT_EQ(after.size(), 1);
+    ASSERT_EQ(after[0].result, 144);
+}
+
+// A dead worker neither blocks submit() nor loses the tasks queued for it.
+TEST(ProcessPool, test3) {
+    auto pool = conq::ProcessPool<int, long, 16, 4>::create(1, square);
+    ASSERT_TRUE(pool.has_value());
+    ASSERT_EQ(kill(pool->pids()[0], SIGKILL), 0);
+
+    std::map<std::uint64_t, int> submitted;
+    const auto poisoned = pool->submit(-1);
+    ASSERT_TRUE(poisoned.has_value());
+    for (int i = 1; i < 4; ++i) {
+        const auto id = pool->submit(i);
+        ASSERT_TRUE(id.has_value());
+        submitted[id.value()] = i;
+    }
+    ASSERT_FALSE(pool->submit(4).has_value());
+
+    std::vector<conq::Completion<long>> completions;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (completions.size() < 4 && std::chrono::steady_clock::now() < deadline) {
+        auto polled = pool->poll();
+        ASSERT_TRUE(polled.has_value());
+        completions.insert(completions.end(), polled->begin(), polled->end());
+    }
+    ASSERT_EQ(completions.size(), 4);
+    ASSERT_EQ(completions[0].id, poisoned.value());
+    ASSERT_EQ(completions[0].status, conq::TaskStatus::Crashed);
+    for (std::size_t i = 1; i < completions.size(); ++i) {
+        ASSERT_EQ(completions[i].status, conq::TaskStatus::Done);
+        const auto value = submitted.at(completions[i].id);
+        ASSERT_EQ(completions[i].result, static_cast<long>(value) * value);
+        submitted.erase(completions[i].id);
+    }
+    ASSERT_TRUE(submitted.empty());
+    ASSERT_EQ(pool->respawns(), 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(pool->poll()->empty());
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
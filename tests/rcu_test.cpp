@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Rcu.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    std::atomic<int> live{};
+
+    // Every entry equal: a reader seeing a half-updated or freed table notices.
+    struct Routes {
+        std::vector<long> next_hop = std::vector<long>(16, 0);
+
+        Routes() {
+            live.fetch_add(1);
+        }
+
+        Routes(const Routes& other) :
+                next_hop(other.next_hop) {
+            live.fetch_add(1);
+        }
+
+        ~Routes() {
+            std::ranges::fill(next_hop, -1);
+            live.fetch_sub(1);
+        }
+
+        [[nodiscard]]
+        bool consistent() const {
+            return std::ranges::all_of(next_hop, [&](long hop) { return hop == next_hop.front() && hop >= 0; });
+        }
+    };
+}
+
+TEST(Rcu, test1) {
+    conq::RcuDomain<4> domain;
+    {
+        conq::RcuPtr<Routes, conq::RcuDomain<4>> routes(domain, std::make_unique<Routes>());
+        auto reader = domain.register_reader();
+        ASSERT_TRUE(reader.has_value());
+
+        const Routes* seen{};
+        {
+            auto guard = reader->read();
+            seen = routes.load();
+            ASSERT_TRUE(seen->consistent());
+        }
+
+        routes.update([](Routes& next) { std::ranges::fill(next.next_hop, 1); });
+        ASSERT_EQ(live.load(), 2);
+        ASSERT_EQ(domain.pending(), 1);
+
+        // The reader has not passed a quiescent point, so the old table stays alive.
+        ASSERT_EQ(domain.reclaim(), 0);
+        ASSERT_TRUE(seen->consistent());
+
+        reader->quiescent();
+        ASSERT_EQ(domain.reclaim(), 1);
+        ASSERT_EQ(live.load(), 1);
+        ASSERT_EQ(routes.load()->next_hop.front(), 1);
+    }
+    ASSERT_EQ(live.load(), 0);
+}
+
+TEST(Rcu, test2) {
+    conq::RcuDomain<4> domain;
+    conq::RcuPtr<Routes, conq::RcuDomain<4>> routes(domain, std::make_unique<Routes>());
+    std::atomic<bool> holding{};
+    std::atomic<bool> released{};
+
+    std::thread reader_thread([&]() {
+        auto reader = domain.register_reader();
+        {
+            auto guard = reader->read();
+            const auto table = routes.load();
+            holding.store(true);
+            std::this_thread::sleep_for(50ms);
+            EXPECT_TRUE(table->consistent());
+            released.store(true);
+        }
+        reader->quiescent();
+    });
+
+    while (!holding.load()) {
+        std::this_thread::yield();
+    }
+    auto old = routes.exchange(std::make_unique<Routes>());
+    ASSERT_TRUE(released.load());
+    ASSERT_TRUE(old->consistent());
+    reader_thread.join();
+}
+
+TEST(Rcu, test3) {
+    constexpr int UPDATES = 2000;
+    {
+        conq::RcuDomain<> domain;
+        conq::RcuPtr<Routes> routes(domain, std::make_unique<Routes>());
+        std::atomic<bool> done{};
+        std::atomic<int> torn{};
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 3; ++i) {
+            readers.emplace_back([&]() {
+                auto reader = domain.register_reader();
+                long last{};
+                while (!done.load(std::memory_order_relaxed)) {
+                    {
+                        auto guard = reader->read();
+                        const auto table = routes.load();
+                        if (!table->consistent() || table->next_hop.front() < last) {
+                            torn.fetch_add(1);
+                        }
+                        last = table->next_hop.front();
+                    }
+                    reader->quiescent();
+                }
+            });
+        }
+
+        for (long i = 1; i <= UPDATES; ++i) {
+            routes.update([i](Routes& next) { std::ranges::fill(next.next_hop, i); });
+        }
+        done.store(true);
+        for (auto& reader: readers) {
+            reader.join();
+        }
+        ASSERT_EQ(torn.load(), 0);
+
+        domain.barrier();
+        ASSERT_EQ(domain.pending(), 0);
+        ASSERT_EQ(live.load(), 1);
+    }
+    ASSERT_EQ(live.load(), 0);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
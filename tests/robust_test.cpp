@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <signal.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "os/Futex.h"
+#include "os/Process.h"
+#include "os/RobustMutex.h"
+#include "os/ShMem.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    struct Guarded {
+        conq::RobustMutex mutex{};
+        conq::RobustCondition ready{};
+        bool flag{};
+    };
+
+    struct Table {
+        conq::RobustRwLock<8> lock{};
+        conq::FutexEvent held{};
+        long a{};
+        long b{};
+    };
+
+    int reap(const conq::Process& process) {
+        while (true) {
+            const auto status = process.try_wait();
+            if (!status.has_value()) {
+                return -1;
+            }
+            if (status->has_value()) {
+                return status->value();
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+}
+
+TEST(RobustMutex, test1) {
+    auto shmem = conq::ShMem::create("/conq_robust_mutex").value();
+    auto shared = shmem.allocate<Guarded>();
+
+    auto child = conq::Process::fork([shared]() {
+        (void) shared->mutex.lock();
+        raise(SIGKILL);
+        return 0;
+    });
+    ASSERT_TRUE(child.has_value());
+    ASSERT_EQ(reap(child.value()), 128 + SIGKILL);
+
+    ASSERT_EQ(shared->mutex.lock(), conq::Acquired::OwnerDied);
+    shared->mutex.unlock();
+    ASSERT_EQ(shared->mutex.lock(), conq::Acquired::Clean);
+    shared->mutex.unlock();
+}
+
+TEST(RobustMutex, test2) {
+    conq::RobustMutex mutex;
+    ASSERT_EQ(mutex.lock(), conq::Acquired::Clean);
+
+    std::thread other([&]() {
+        const auto busy = mutex.try_lock();
+        ASSERT_FALSE(busy.has_value());
+        ASSERT_EQ(busy.error().code(), EBUSY);
+
+        const auto timed_out = mutex.try_lock_for(10ms);
+        ASSERT_FALSE(timed_out.has_value());
+        ASSERT_EQ(timed_out.error().code(), ETIMEDOUT);
+    });
+    other.join();
+    mutex.unlock();
+}
+
+TEST(RobustCondition, test1) {
+    auto shmem = conq::ShMem::create("/conq_robust_condition").value();
+    auto shared = shmem.allocate<Guarded>();
+
+    auto child = conq::Process::fork([shared]() {
+        (void) shared->mutex.lock();
+        shared->flag = true;
+        shared->ready.notify_all();
+        shared->mutex.unlock();
+        return 0;
+    });
+    ASSERT_TRUE(child.has_value());
+
+    ASSERT_TRUE(shared->mutex.lock().has_value());
+    while (!shared->flag) {
+        const auto woken = shared->ready.wait_for(shared->mutex, 10s);
+        ASSERT_TRUE(woken.has_value());
+    }
+    shared->mutex.unlock();
+    ASSERT_EQ(child->wait(), 0);
+}
+
+TEST(RobustRwLock, test1) {
+    constexpr int WRITES = 2000;
+    Table table;
+    std::atomic<bool> done{};
+    std::atomic<int> torn{};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&]() {
+            const auto slot = table.lock.register_reader();
+            ASSERT_TRUE(slot.has_value());
+            while (!done.load()) {
+                table.lock.lock_shared(slot.value());
+                if (table.a != table.b) {
+                    torn.fetch_add(1);
+                }
+                table.lock.unlock_shared(slot.value());
+            }
+            table.lock.unregister_reader(slot.value());
+        });
+    }
+
+    for (int i = 0; i < WRITES; ++i) {
+        ASSERT_EQ(table.lock.lock(), conq::Acquired::Clean);
+        ++table.a;
+        ++table.b;
+        table.lock.unlock();
+    }
+    done.store(true);
+    for (auto& reader: readers) {
+        reader.join();
+    }
+    ASSERT_EQ(torn.load(), 0);
+    ASSERT_EQ(table.a, WRITES);
+}
+
+// A reader that dies inside its read section does not block writers.
+TEST(RobustRwLock, test2) {
+    auto shmem = conq::ShMem::create("/conq_robust_rw_reader").value();
+    auto shared = shmem.allocate<Table>();
+
+    auto child = conq::Process::fork([shared]() {
+        const auto slot = shared->lock.register_reader();
+        shared->lock.lock_shared(slot.value());
+        raise(SIGKILL);
+        return 0;
+    });
+    ASSERT_TRUE(child.has_value());
+    ASSERT_EQ(reap(child.value()), 128 + SIGKILL);
+
+    ASSERT_EQ(shared->lock.lock(), conq::Acquired::Clean);
+    shared->lock.unlock();
+}
+
+// Readers blocked behind a writer that dies recover, and the next writer is told.
+TEST(RobustRwLock, test3) {
+    auto shmem = conq::ShMem::create("/conq_robust_rw_writer").value();
+    auto shared = shmem.allocate<Table>();
+
+    auto child = conq::Process::fork([shared]() {
+        (void) shared->lock.lock();
+        ++shared->a;
+        shared->held.set();
+        std::this_thread::sleep_for(50ms);
+        raise(SIGKILL);
+        return 0;
+    });
+    ASSERT_TRUE(child.has_value());
+    ASSERT_TRUE(shared->held.wait_for(10s));
+
+    const auto slot = shared->lock.register_reader();
+    ASSERT_TRUE(slot.has_value());
+    shared->lock.lock_shared(slot.value());
+    ASSERT_NE(shared->a, shared->b);
+    shared->lock.unlock_shared(slot.value());
+    ASSERT_EQ(reap(child.value()), 128 + SIGKILL);
+
+    ASSERT_EQ(shared->lock.lock(), conq::Acquired::OwnerDied);
+    shared->b = shared->a;
+    shared->lock.unlock();
+    ASSERT_EQ(shared->lock.lock(), conq::Acquired::Clean);
+    shared->lock.unlock();
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -2,6 +2,8 @@
 
 #include "SPSCBoundedQueue.h"
 #include "SPSC.h"
+#include "QueueStats.h"
+#include "allocation/MemoryResource.h"
 
 TEST(SPSCBoundedQ, test1) {
     conq::SPSCMailBox<int, 4> queue;
@@ -59,6 +61,36 @@ TEST(SPSCBoundedQ, test2) {
     producer.join();
 }
 
+TEST(SPSCBoundedQ, test3) {
+    conq::SPSCMailBox<int, 4, conq::QueueStats<>> queue;
+    for (int i = 0; i < 5; ++i) {
+        (void) queue.try_push(i);
+    }
+    while (queue.try_pop().has_value()) {}
+    ASSERT_TRUE(queue.try_push(5));
+
+    const auto stats = queue.stats().snapshot();
+    ASSERT_EQ(stats.push, 5);
+    ASSERT_EQ(stats.full, 1);
+    ASSERT_EQ(stats.pop, 4);
+    ASSERT_EQ(stats.empty, 1);
+    ASSERT_EQ(stats.high_water, 4);
+}
+
+TEST(SPSCBoundedQ, test4) {
+    conq::SPSCMailBox<int, 4> queue;
+    ASSERT_FALSE(queue.front().has_value());
+    ASSERT_TRUE(queue.try_push(1));
+    ASSERT_TRUE(queue.try_push(2));
+
+    ASSERT_EQ(queue.front(), 1);
+    ASSERT_EQ(queue.front(), 1);
+    ASSERT_EQ(queue.try_pop(), 1);
+    ASSERT_EQ(queue.front(), 2);
+    ASSERT_EQ(queue.try_pop(), 2);
+    ASSERT_FALSE(queue.front().has_value());
+}
+
 TEST(SPSC, test1) {
     conq::SPSCQueue<int> queue;
     queue.push(1);
@@ -96,6 +128,36 @@ TEST(SPSC, test2) {
 
 }
 
+TEST(SPSC, test3) {
+    using Allocator = conq::memory::ResourceAllocator<conq::Slot<int>>;
+    conq::memory::ConcurrentPoolResource<sizeof(conq::Slot<int>), 8, alignof(conq::Slot<int>)> pool;
+    conq::SPSCQueue<int, Allocator> queue(Allocator{&pool});
+
+    auto producer_fn = [](conq::SPSCQueue<int, Allocator> &queue) {
+        for (int i = 0; i < 1000; ++i) {
+            queue.push(i);
+        }
+    };
+
+    auto consumer_fn = [](conq::SPSCQueue<int, Allocator> &queue) {
+        for (int i = 0; i < 1000; ++i) {
+            while (true) {
+                auto val = queue.pop();
+                if (val.has_value()) {
+                    EXPECT_EQ(val.value(), i);
+                    break;
+                }
+            }
+        }
+    };
+
+    std::thread producer(producer_fn, std::ref(queue));
+    std::thread consumer(consumer_fn, std::ref(queue));
+
+    consumer.join();
+    producer.join();
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
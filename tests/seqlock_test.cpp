@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "SeqLock.h"
+#include "os/Process.h"
+#include "os/ShMem.h"
+
+namespace {
+    // Every field equal: a torn copy shows up as a mismatch.
+    struct Quote {
+        long bid{};
+        long ask{};
+        long size{};
+        int venue{};
+
+        [[nodiscard]]
+        bool consistent() const {
+            return ask == bid && size == bid && venue == static_cast<int>(bid);
+        }
+    };
+
+    Quote quote(long value) {
+        return Quote{value, value, value, static_cast<int>(value)};
+    }
+}
+
+TEST(SeqLock, test1) {
+    conq::SeqLock<Quote> cell;
+    ASSERT_EQ(cell.version(), 0);
+
+    cell.store(quote(7));
+    const auto loaded = cell.load();
+    ASSERT_EQ(loaded.version, 1);
+    ASSERT_EQ(loaded.value.bid, 7);
+    ASSERT_TRUE(cell.try_load().has_value());
+}
+
+TEST(SeqLock, test2) {
+    constexpr long STORES = 200000;
+    conq::SeqLock<Quote> cell(quote(0));
+    std::atomic<bool> done{};
+    std::atomic<int> torn{};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&]() {
+            std::uint64_t last{};
+            while (!done.load(std::memory_order_relaxed)) {
+                const auto loaded = cell.load();
+                if (!loaded.value.consistent() || loaded.version < last) {
+                    torn.fetch_add(1);
+                }
+                last = loaded.version;
+            }
+        });
+    }
+
+    for (long i = 1; i <= STORES; ++i) {
+        cell.store(quote(i));
+    }
+    done.store(true);
+    for (auto& reader: readers) {
+        reader.join();
+    }
+    ASSERT_EQ(torn.load(), 0);
+    ASSERT_EQ(cell.load().value.bid, STORES);
+}
+
+TEST(SeqRing, test1) {
+    conq::SeqRing<Quote, 4> ring;
+    ASSERT_FALSE(ring.latest().has_value());
+    ASSERT_FALSE(ring.read(1).has_value());
+
+    for (long i = 1; i <= 6; ++i) {
+        ASSERT_EQ(ring.publish(quote(i * 10)), static_cast<std::uint64_t>(i));
+    }
+    ASSERT_EQ(ring.version(), 6);
+    ASSERT_EQ(ring.oldest(), 4);
+    ASSERT_EQ(ring.latest()->value.bid, 60);
+    ASSERT_EQ(ring.read(4)->bid, 40);
+    ASSERT_FALSE(ring.read(2).has_value());
+    ASSERT_FALSE(ring.read(7).has_value());
+}
+
+TEST(SeqRing, test2) {
+    constexpr long VERSIONS = 100000;
+    auto shmem = conq::ShMem::create("/conq_seqring").value();
+    auto ring = shmem.allocate<conq::SeqRing<Quote, 64>>();
+
+    auto reader = conq::Process::fork([ring]() {
+        std::uint64_t seen{};
+        while (seen < VERSIONS) {
+            const auto latest = ring->latest();
+            if (!latest.has_value()) {
+                continue;
+            }
+            if (!latest->value.consistent() || latest->value.bid != static_cast<long>(latest->version)) {
+                return 1;
+            }
+            seen = latest->version;
+        }
+        return 0;
+    });
+    ASSERT_TRUE(reader.has_value());
+
+    for (long i = 1; i <= VERSIONS; ++i) {
+        ring->publish(quote(i));
+    }
+    ASSERT_EQ(reader->wait(), 0);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Rcu.h"
+#include "SkipList.h"
+
+namespace {
+    struct Level {
+        long price{};
+        long quantity{};
+    };
+}
+
+TEST(SkipList, test1) {
+    conq::RcuDomain<> domain;
+    {
+        auto reader = domain.register_reader();
+        ASSERT_TRUE(reader.has_value());
+
+        auto list = std::make_unique<conq::SkipList<long, Level, 64>>(domain);
+        ASSERT_TRUE(list->empty());
+        ASSERT_FALSE(list->front().has_value());
+
+        for (const long price: {105, 101, 103, 102, 104}) {
+            ASSERT_EQ(list->insert(price, Level{price, price * 10}), true);
+        }
+        ASSERT_EQ(list->insert(103, Level{}), false);
+        ASSERT_EQ(list->size(), 5);
+        ASSERT_EQ(list->find(103)->quantity, 1030);
+        ASSERT_FALSE(list->find(100).has_value());
+        ASSERT_EQ(list->front()->first, 101);
+
+        std::vector<long> prices;
+        ASSERT_EQ(list->range(102, 105, [&](long price, const Level& level) {
+            ASSERT_EQ(level.price, price);
+            prices.push_back(price);
+        }), 3);
+        ASSERT_EQ(prices, (std::vector<long>{102, 103, 104}));
+
+        ASSERT_TRUE(list->erase(101));
+        ASSERT_FALSE(list->erase(101));
+        ASSERT_EQ(list->front()->first, 102);
+        ASSERT_EQ(list->size(), 4);
+        reader->offline();
+    }
+}
+
+// Erased nodes go back to the pool, so churn far beyond N does not exhaust it.
+TEST(SkipList, test2) {
+    conq::RcuDomain<> domain;
+    auto list = std::make_unique<conq::SkipList<int, int, 16>>(domain);
+    {
+        auto reader = domain.register_reader();
+        for (int i = 0; i < 16; ++i) {
+            ASSERT_EQ(list->insert(i, i), true);
+        }
+        ASSERT_FALSE(list->insert(16, 16).has_value());
+
+        for (int i = 16; i < 10000; ++i) {
+            ASSERT_TRUE(list->erase(i - 16));
+            reader->quiescent();
+            ASSERT_EQ(list->insert(i, i), true);
+        }
+        ASSERT_EQ(list->size(), 16);
+        ASSERT_EQ(list->front()->first, 10000 - 16);
+    }
+}
+
+TEST(SkipList, test3) {
+    constexpr int WRITERS = 3;
+    constexpr int KEYS = 512;
+    constexpr int ROUNDS = 20;
+
+    conq::RcuDomain<> domain;
+    auto list = std::make_unique<conq::SkipList<int, int, 4096>>(domain);
+    std::atomic<int> writing{WRITERS};
+    std::atomic<long> unordered{};
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < WRITERS; ++w) {
+        threads.emplace_back([&, w]() {
+            auto reader = domain.register_reader();
+            // Interleaved key sets: the writers contend on the same neighbourhoods.
+            for (int round = 0; round < ROUNDS; ++round) {
+                for (int key = w; key < KEYS * WRITERS; key += WRITERS) {
+                    // A descheduled reader holds erased nodes back from the pool.
+                    auto inserted = list->insert(key, key * 2);
+                    while (!inserted.has_value()) {
+                        reader->quiescent();
+                        std::this_thread::yield();
+                        inserted = list->insert(key, key * 2);
+                    }
+                    EXPECT_TRUE(inserted.value());
+                    reader->quiescent();
+                }
+                reader->quiescent();
+                if (round + 1 < ROUNDS) {
+                    for (int key = w; key < KEYS * WRITERS; key += WRITERS) {
+                        EXPECT_TRUE(list->erase(key));
+                        reader->quiescent();
+                    }
+                }
+                reader->quiescent();
+            }
+            reader->offline();
+            writing.fetch_sub(1);
+        });
+    }
+    threads.emplace_back([&]() {
+        auto reader = domain.register_reader();
+        while (writing.load() != 0) {
+            int last = -1;
+            list->range(0, KEYS * WRITERS, [&](int key, int value) {
+                if (key <= last || value != key * 2) {
+                    unordered.fetch_add(1);
+                }
+                last = key;
+            });
+            reader->quiescent();
+        }
+        reader->offline();
+    });
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(unordered.load(), 0);
+    ASSERT_EQ(list->size(), KEYS * WRITERS);
+    auto reader = domain.register_reader();
+    int expected = 0;
+    ASSERT_EQ(list->range(0, KEYS * WRITERS, [&](int key, int value) {
+        ASSERT_EQ(key, expected++);
+        ASSERT_EQ(value, key * 2);
+    }), KEYS * WRITERS);
+    reader->offline();
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
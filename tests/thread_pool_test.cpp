@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <sched.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "QueueStats.h"
+#include "ThreadPool.h"
+#include "WorkStealingDeque.h"
+
+namespace {
+    long fib(conq::ThreadPool& pool, int n) {
+        if (n < 2) {
+            return n;
+        }
+        if (n < 12) {
+            return fib(pool, n - 1) + fib(pool, n - 2);
+        }
+
+        long left{};
+        conq::TaskGroup group;
+        pool.spawn(group, [&]() { left = fib(pool, n - 1); });
+        const auto right = fib(pool, n - 2);
+        pool.wait(group);
+        return left + right;
+    }
+}
+
+TEST(WorkStealingDeque, test1) {
+    conq::WorkStealingDeque<int, conq::QueueStats<>> deque(2);
+    for (int i = 0; i < 10; ++i) {
+        deque.push(i);
+    }
+    ASSERT_EQ(deque.size(), 10);
+
+    // Owner takes the newest, thieves the oldest.
+    ASSERT_EQ(deque.pop(), 9);
+    ASSERT_EQ(deque.steal(), 0);
+    ASSERT_EQ(deque.steal(), 1);
+    ASSERT_EQ(deque.pop(), 8);
+    while (deque.pop().has_value()) {}
+    ASSERT_TRUE(deque.empty());
+    ASSERT_FALSE(deque.steal().has_value());
+
+    const auto stats = deque.stats().snapshot();
+    ASSERT_EQ(stats.push, 10);
+    ASSERT_EQ(stats.pop, 10);
+    ASSERT_EQ(stats.high_water, 10);
+}
+
+TEST(WorkStealingDeque, test2) {
+    constexpr std::uint64_t ITEMS = 200000;
+    conq::WorkStealingDeque<std::uint64_t> deque(16);
+    std::vector<std::atomic<int>> taken(ITEMS);
+    std::atomic<bool> done{};
+
+    auto thief = [&]() {
+        while (!done.load(std::memory_order_acquire) || !deque.empty()) {
+            if (const auto item = deque.steal(); item.has_value()) {
+                taken[item.value()].fetch_add(1);
+            }
+        }
+    };
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; ++i) {
+        thieves.emplace_back(thief);
+    }
+
+    for (std::uint64_t i = 0; i < ITEMS; ++i) {
+        deque.push(i);
+        if (i % 3 == 0) {
+            if (const auto item = deque.pop(); item.has_value()) {
+                taken[item.value()].fetch_add(1);
+            }
+        }
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& thread: thieves) {
+        thread.join();
+    }
+
+    for (const auto& count: taken) {
+        ASSERT_EQ(count.load(), 1);
+    }
+}
+
+TEST(ThreadPool, test1) {
+    auto pool = conq::ThreadPool::create(3);
+    ASSERT_TRUE(pool.has_value());
+
+    constexpr int TASKS = 1000;
+    std::vector<long> results(TASKS);
+    conq::TaskGroup group;
+    for (int i = 0; i < TASKS; ++i) {
+        (*pool)->spawn(group, [&results, i]() { results[i] = static_cast<long>(i) * i; });
+    }
+    (*pool)->wait(group);
+    ASSERT_TRUE(group.done());
+
+    for (int i = 0; i < TASKS; ++i) {
+        ASSERT_EQ(results[i], static_cast<long>(i) * i);
+    }
+}
+
+TEST(ThreadPool, test2) {
+    auto pool = conq::ThreadPool::create(4);
+    ASSERT_TRUE(pool.has_value());
+
+    long result{};
+    conq::TaskGroup group;
+    (*pool)->spawn(group, [&]() { result = fib(**pool, 24); });
+    (*pool)->wait(group);
+    ASSERT_EQ(result, 46368);
+    ASSERT_EQ((*pool)->current_worker(), -1);
+}
+
+TEST(ThreadPool, test3) {
+    std::atomic<int> ran{};
+    {
+        const conq::Placement placements[] = {conq::Placement::on(0)};
+        auto pool = conq::ThreadPool::create(2, placements);
+        ASSERT_TRUE(pool.has_value());
+        for (int i = 0; i < 100; ++i) {
+            (*pool)->submit([&]() {
+                EXPECT_EQ(sched_getcpu(), 0);
+                ran.fetch_add(1);
+            });
+        }
+    }
+    // The destructor drains submitted work.
+    ASSERT_EQ(ran.load(), 100);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "TimedQueue.h"
+#include "SPSCBoundedQueue.h"
+#include "channel/TimedChannel.h"
+#include "os/Tsc.h"
+
+TEST(Tsc, test1) {
+    const auto& tsc = conq::Tsc::calibration();
+    // Any TSC runs between 100 MHz and 10 GHz.
+    ASSERT_GT(tsc.ticks_per_ns(), 0.1);
+    ASSERT_LT(tsc.ticks_per_ns(), 10.0);
+
+    const auto stamp = conq::Tsc::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const auto elapsed = tsc.since(stamp);
+    ASSERT_GE(elapsed, 9'000'000);
+    ASSERT_LT(elapsed, 1'000'000'000);
+
+    ASSERT_EQ(tsc.since(conq::Tsc::now() + 1'000'000'000), 0);
+}
+
+TEST(TimedQueue, test1) {
+    conq::TimedQueue<int, 4> queue;
+    ASSERT_TRUE(queue.try_push(1));
+    ASSERT_TRUE(queue.try_push(2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    ASSERT_EQ(queue.try_pop().value(), 1);
+    ASSERT_EQ(queue.try_pop().value(), 2);
+    ASSERT_FALSE(queue.try_pop().has_value());
+
+    const auto residence = queue.residence().snapshot();
+    ASSERT_EQ(residence.count(), 2);
+    ASSERT_GE(residence.min(), 1'000'000);
+}
+
+TEST(TimedQueue, test2) {
+    conq::TimedQueue<std::string, 4, conq::SPSCMailBox> queue;
+    ASSERT_TRUE(queue.try_push("message"));
+    ASSERT_EQ(queue.try_pop().value(), "message");
+    ASSERT_EQ(queue.residence().snapshot().count(), 1);
+}
+
+TEST(TimedChannel, test1) {
+    auto writer = conq::TimedChannelWriter<4>::create("/test").value();
+    conq::metrics::Histogram residence;
+    auto reader = conq::TimedChannelReader<4>::open("/test", residence).value();
+
+    // Header (2 buckets) and "Hello" fit; then a 20-byte message that needs resuming.
+    ASSERT_EQ(writer.write("Hello", 5), 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    std::string data(5, '\0');
+    bool complete{};
+    ASSERT_EQ(reader.read(data, complete), 5);
+    ASSERT_TRUE(complete);
+    ASSERT_EQ(data, "Hello");
+    ASSERT_EQ(residence.snapshot().count(), 1);
+    ASSERT_GE(residence.snapshot().min(), 1'000'000);
+
+    const std::string message = "0123456789abcdefghij";
+    std::string received(message.size(), '\0');
+    std::size_t written = writer.write(message.data(), message.size());
+    std::size_t read{};
+    while (read < message.size()) {
+        read += reader.read(std::span{received.data() + read, received.size() - read}, complete);
+        if (written < message.size()) {
+            written += writer.write(message.data() + written, message.size() - written);
+        }
+    }
+    ASSERT_TRUE(complete);
+    ASSERT_EQ(received, message);
+    ASSERT_EQ(residence.snapshot().count(), 2);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}